@@ -0,0 +1,71 @@
+#include <algorithm>
+#include "adaptive_rate_controller.h"
+
+namespace watchList
+{
+static std::string_view INCREASE_THROTTLE_DECISION_STR = "increase";
+static std::string_view HOLD_THROTTLE_DECISION_STR = "hold";
+static std::string_view DECREASE_THROTTLE_DECISION_STR = "decrease";
+
+std::string_view getThrottleDecision(EThrottleDecision decision)
+{
+    switch (decision)
+    {
+        case EThrottleDecision::INCREASE:
+            return INCREASE_THROTTLE_DECISION_STR;
+        case EThrottleDecision::HOLD:
+            return HOLD_THROTTLE_DECISION_STR;
+        case EThrottleDecision::DECREASE:
+            return DECREASE_THROTTLE_DECISION_STR;
+    }
+    return HOLD_THROTTLE_DECISION_STR;
+}
+
+double CAdaptiveRateController::DECREASE_FACTOR = 0.5;
+
+CAdaptiveRateController::CAdaptiveRateController(const CHostRateLimit& rateLimit)
+    : _rateLimit(rateLimit)
+    , _rate(rateLimit.getRequestsPerSecond())
+{
+}
+
+bool CAdaptiveRateController::isOverloaded(const CDownloadResult& result) const
+{
+    // other client errors like missing page say nothing about server load
+    int statusCode = result.getStatusCode();
+    return (statusCode == 0) || (statusCode == 429) || (statusCode >= 500);
+}
+
+EThrottleDecision CAdaptiveRateController::update(const CDownloadResult& result, Clock::time_point startTime, Clock::time_point now)
+{
+    if (!isAdaptive())
+    {
+        return EThrottleDecision::HOLD;
+    }
+
+    auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime);
+    double minRate = _rateLimit.getMinRequestsPerSecond();
+    double maxRate = std::max(_rateLimit.getMaxRequestsPerSecond(), _rateLimit.getRequestsPerSecond());
+
+    if ((!result.isSuccess() && isOverloaded(result)) || (latency.count() > 2 * _rateLimit.getMaxLatencyMs()))
+    {
+        _reason = result.isSuccess() ? "latency " + std::to_string(latency.count()) + " ms" : result.getErrorMessage();
+        // requests sent before the previous decrease see the same overload, rate is cut only once for them
+        if (startTime < _lastDecreaseTime)
+        {
+            return EThrottleDecision::HOLD;
+        }
+        _rate = std::max(minRate, _rate * DECREASE_FACTOR);
+        _lastDecreaseTime = now;
+        return EThrottleDecision::DECREASE;
+    }
+    if (!result.isSuccess() || (latency.count() > _rateLimit.getMaxLatencyMs()))
+    {
+        _reason = result.isSuccess() ? "latency " + std::to_string(latency.count()) + " ms" : result.getErrorMessage();
+        return EThrottleDecision::HOLD;
+    }
+    _reason.clear();
+    _rate = std::min(maxRate, _rate + _rateLimit.getRateStep());
+    return EThrottleDecision::INCREASE;
+}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include "download_backend.h"
+#include "downloader_settings.h"
+
+namespace watchList
+{
+    enum class EThrottleDecision
+    {
+        INCREASE = 0,
+        HOLD,
+        DECREASE
+    };
+
+    std::string_view getThrottleDecision(EThrottleDecision decision);
+
+    // Additive increase while host answers fast and successfully, multiplicative decrease when it is overloaded
+    class CAdaptiveRateController
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+    public:
+        CAdaptiveRateController(const CHostRateLimit& rateLimit);
+
+    public:
+        // host with rate 0 or less isn't limited, it stays unlimited
+        bool isAdaptive() const
+            { return _rateLimit.getRequestsPerSecond() > 0.0; }
+
+        EThrottleDecision update(const CDownloadResult& result, Clock::time_point startTime, Clock::time_point now);
+
+        double getRate() const
+            { return _rate; }
+
+        const std::string& getReason() const
+            { return _reason; }
+
+    private:
+        static double DECREASE_FACTOR;
+
+    private:
+        bool isOverloaded(const CDownloadResult& result) const;
+
+    private:
+        CHostRateLimit _rateLimit;
+        double _rate;
+        std::string _reason;
+        Clock::time_point _lastDecreaseTime;
+    };
+}
@@ -9,4 +9,5 @@ namespace watchList
     const std::string TEMPLATE_DISKUNION_PATH = DATA_DIR + "templateDiskunionHtml.txt";
     const std::string YAHOO_KEYWORDS_DEFAULT_FILE_NAME = "yahoo_keywords.txt";
     const std::string DISKUNION_ITEMS_DEFAULT_FILE_NAME = "diskunion_items.txt";
+    const std::string DOWNLOAD_HOSTS_DEFAULT_FILE_NAME = "download_hosts.txt";
 }
@@ -11,4 +11,5 @@ namespace watchList
     extern const std::string TEMPLATE_DISKUNION_PATH;
     extern const std::string YAHOO_KEYWORDS_DEFAULT_FILE_NAME;
     extern const std::string DISKUNION_ITEMS_DEFAULT_FILE_NAME;
+    extern const std::string DOWNLOAD_HOSTS_DEFAULT_FILE_NAME;
 }
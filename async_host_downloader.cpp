@@ -0,0 +1,177 @@
+#include <boost/asio/error.hpp>
+#include <algorithm>
+#include "async_host_downloader.h"
+
+using namespace boost::asio;
+using namespace boost::beast;
+using namespace boost::system;
+
+namespace watchList
+{
+CAsyncHostDownloader::CAsyncHostDownloader(net::io_context& ioContext, CDnsCache& dnsCache, std::string_view host, std::string_view port,
+    const CDownloadTimeouts& timeouts)
+    : _ioContext(ioContext)
+    , _sslContext(ssl::context::tlsv12_client)
+    , _host(host)
+    , _port(port)
+    , _timeouts(timeouts)
+    , _dnsCache(dnsCache)
+    , _connectHost(host)
+    , _connectPort(port)
+    , _tlsSession(nullptr)
+{
+    // sessions are kept by downloader itself, openssl only reports new ones
+    SSL_CTX_set_ex_data(_sslContext.native_handle(), getSslContextDataIndex(), this);
+    SSL_CTX_set_session_cache_mode(_sslContext.native_handle(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(_sslContext.native_handle(), onNewTlsSession);
+}
+
+CAsyncHostDownloader::~CAsyncHostDownloader()
+{
+    if (_tlsSession != nullptr)
+    {
+        SSL_SESSION_free(_tlsSession);
+    }
+}
+
+int CAsyncHostDownloader::getSslContextDataIndex()
+{
+    // app data of context is taken by asio for its callbacks
+    static int dataIndex = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return dataIndex;
+}
+
+int CAsyncHostDownloader::onNewTlsSession(SSL* ssl, SSL_SESSION* session)
+{
+    auto ptrThis = static_cast<CAsyncHostDownloader*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), getSslContextDataIndex()));
+    if (ptrThis->_tlsSession != nullptr)
+    {
+        SSL_SESSION_free(ptrThis->_tlsSession);
+    }
+    ptrThis->_tlsSession = session;
+    // downloader owns the session now
+    return 1;
+}
+
+void CAsyncHostDownloader::prepareStream(SslStream& stream)
+{
+    // most of the hosts are behind CDN which requires SNI to pick the certificate
+    SSL_set_tlsext_host_name(stream.native_handle(), _host.c_str());
+    if (_tlsSession != nullptr)
+    {
+        SSL_set_session(stream.native_handle(), _tlsSession);
+    }
+}
+
+CAsyncHostDownloader::CConnectOperation::CConnectOperation(io_context& ioContext, ConnectHandler handler)
+    : _resolveTimer(ioContext)
+    , _isResolved(false)
+    , _isCompleted(false)
+    , _handler(std::move(handler))
+{
+}
+
+void CAsyncHostDownloader::CConnectOperation::cancel()
+{
+    if (_isResolved)
+    {
+        // connector completes with operation_aborted, it does nothing after connect
+        if (auto ptrConnector = _weakPtrConnector.lock())
+        {
+            ptrConnector->cancel();
+        }
+    }
+    else if (!_isCompleted)
+    {
+        _isCompleted = true;
+        _resolveTimer.cancel();
+        _handler(error::operation_aborted);
+    }
+}
+
+CAsyncHostDownloader::CConnectOperation::SharedPtr CAsyncHostDownloader::connectStream(SslStream& stream, ConnectHandler handler)
+{
+    auto ptrOperation = std::make_shared<CConnectOperation>(_ioContext, std::move(handler));
+    // resolve is shared by requests of the host, request which is late only stops waiting for it
+    ptrOperation->_resolveTimer.expires_after(_timeouts.getConnect());
+    ptrOperation->_resolveTimer.async_wait(
+        [ptrOperation](const error_code& errorCode)
+        {
+            if (!errorCode && !ptrOperation->_isResolved && !ptrOperation->_isCompleted)
+            {
+                ptrOperation->_isCompleted = true;
+                ptrOperation->_handler(error::timed_out);
+            }
+        });
+
+    _dnsCache.asyncResolve(_connectHost, _connectPort,
+        [this, &stream, ptrOperation](const error_code& errorCode, const CDnsCache::ResolveResults& resolveResults)
+        {
+            if (ptrOperation->_isCompleted)
+            {
+                return;
+            }
+            ptrOperation->_isResolved = true;
+            if (errorCode)
+            {
+                ptrOperation->_isCompleted = true;
+                ptrOperation->_resolveTimer.cancel();
+                ptrOperation->_handler(errorCode);
+                return;
+            }
+            // connect takes the rest of the time
+            auto timeout = std::max(ptrOperation->_resolveTimer.expiry() - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration::zero());
+            ptrOperation->_resolveTimer.cancel();
+            ptrOperation->_weakPtrConnector = CEndpointConnector::asyncConnect(_ioContext, resolveResults, timeout,
+                [this, &stream, ptrOperation](const error_code& errorCode, ip::tcp::socket&& socket)
+                {
+                    ptrOperation->_isCompleted = true;
+                    if (errorCode)
+                    {
+                        if (errorCode != error::operation_aborted)
+                        {
+                            // host may have moved to other addresses
+                            _dnsCache.invalidate(_connectHost, _connectPort);
+                        }
+                        ptrOperation->_handler(errorCode);
+                        return;
+                    }
+                    get_lowest_layer(stream).socket() = std::move(socket);
+                    get_lowest_layer(stream).expires_after(_timeouts.getHandshake());
+                    stream.async_handshake(ssl::stream_base::client, ptrOperation->_handler);
+                });
+        });
+    return ptrOperation;
+}
+
+void CAsyncHostDownloader::setConnectAddress(std::string_view host, std::string_view port)
+{
+    _connectHost = host;
+    _connectPort = port;
+}
+
+CAsyncHostDownloader::FutureResponseType CAsyncHostDownloader::asyncDownload(std::string_view target)
+{
+    auto ptrPromise = std::make_shared<std::promise<ResponseType>>();
+    asyncDownload(target,
+        [ptrPromise](const error_code& errorCode, ResponseType&& response)
+        {
+            if (errorCode)
+            {
+                ptrPromise->set_exception(std::make_exception_ptr(system_error(errorCode)));
+            }
+            else
+            {
+                ptrPromise->set_value(std::move(response));
+            }
+        });
+    return ptrPromise->get_future();
+}
+
+awaitable<CAsyncHostDownloader::ResponseType> CAsyncHostDownloader::fetch(std::string target, const CCancellationToken& cancellationToken,
+    const CResponseCutoff& cutoff)
+{
+    // target is kept by value, coroutine may be resumed after caller's string is gone
+    co_return co_await fetch(std::string_view(target), use_awaitable, cancellationToken, cutoff);
+}
+}
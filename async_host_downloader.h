@@ -0,0 +1,150 @@
+#pragma once
+
+// boost 1.74 awaitable.hpp uses std::exchange without including it
+#include <utility>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/beast/core/tcp_stream.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/string_body.hpp>
+#include <boost/beast/ssl/ssl_stream.hpp>
+#include <string>
+#include <memory>
+#include <future>
+#include <functional>
+#include "dns_cache.h"
+#include "endpoint_connector.h"
+#include "download_backend.h"
+#include "cancellation_token.h"
+#include "response_cutoff.h"
+
+namespace watchList
+{
+    // Downloads pages from one host over TLS, derived classes implement the HTTP version.
+    // All methods must be called from io context thread, returned future can be waited from any thread.
+    class CAsyncHostDownloader
+    {
+    public:
+        typedef boost::beast::http::response<boost::beast::http::string_body> ResponseType;
+        typedef std::future<ResponseType> FutureResponseType;
+        typedef std::function<void(const boost::system::error_code& errorCode, ResponseType&& response)> CompletionHandler;
+        typedef std::unique_ptr<CAsyncHostDownloader> UniquePtr;
+
+    public:
+        virtual ~CAsyncHostDownloader();
+
+        CAsyncHostDownloader(const CAsyncHostDownloader&) = delete;
+        CAsyncHostDownloader& operator=(const CAsyncHostDownloader&) = delete;
+
+    public:
+        FutureResponseType asyncDownload(std::string_view target);
+        // Cancelled download completes with operation_aborted error.
+        // Body isn't read any further when cutoff finds the end of needed content.
+        virtual void asyncDownload(std::string_view target, CompletionHandler handler, const CCancellationToken& cancellationToken = CCancellationToken(),
+            const CResponseCutoff& cutoff = CResponseCutoff()) = 0;
+
+        // Completion token version of asyncDownload, e.g. co_await downloader.fetch(target, boost::asio::use_awaitable).
+        // Handler is called through its associated executor.
+        template <class CompletionToken>
+        auto fetch(std::string_view target, CompletionToken&& token, const CCancellationToken& cancellationToken = CCancellationToken(),
+            const CResponseCutoff& cutoff = CResponseCutoff());
+
+        // throws system_error if download fails
+        boost::asio::awaitable<ResponseType> fetch(std::string target, const CCancellationToken& cancellationToken = CCancellationToken(),
+            const CResponseCutoff& cutoff = CResponseCutoff());
+
+        // opens connections in advance, so first requests don't wait for connect and handshake
+        virtual void preconnect(int numConnections) = 0;
+
+        // Connections go to given address instead of the host, e.g. to replay server.
+        // Host is still sent in SNI and requests.
+        void setConnectAddress(std::string_view host, std::string_view port);
+
+    protected:
+        typedef boost::beast::ssl_stream<boost::beast::tcp_stream> SslStream;
+        typedef std::function<void(const boost::system::error_code& errorCode)> ConnectHandler;
+
+        // Resolve and TCP connect of one stream, both are limited by connect timeout.
+        // Handshake isn't covered, stream itself is cancelled then.
+        class CConnectOperation
+        {
+        public:
+            typedef std::shared_ptr<CConnectOperation> SharedPtr;
+
+        public:
+            CConnectOperation(boost::asio::io_context& ioContext, ConnectHandler handler);
+
+        public:
+            // handler gets operation_aborted error, pending resolve is left to other requests of the host
+            void cancel();
+
+        private:
+            friend class CAsyncHostDownloader;
+
+        private:
+            boost::asio::steady_timer _resolveTimer;
+            std::weak_ptr<CEndpointConnector> _weakPtrConnector;
+            bool _isResolved;
+            bool _isCompleted;
+            ConnectHandler _handler;
+        };
+
+    protected:
+        CAsyncHostDownloader(boost::asio::io_context& ioContext, CDnsCache& dnsCache, std::string_view host, std::string_view port,
+            const CDownloadTimeouts& timeouts);
+
+        // sets SNI and resumes the last TLS session of the host
+        void prepareStream(SslStream& stream);
+        // resolve, connect and handshake, handler has to keep the stream alive
+        CConnectOperation::SharedPtr connectStream(SslStream& stream, ConnectHandler handler);
+
+    protected:
+        boost::asio::io_context& _ioContext;
+        boost::asio::ssl::context _sslContext;
+        std::string _host;
+        std::string _port;
+        CDownloadTimeouts _timeouts;
+
+    private:
+        static int getSslContextDataIndex();
+        static int onNewTlsSession(SSL* ssl, SSL_SESSION* session);
+
+    private:
+        CDnsCache& _dnsCache;
+        std::string _connectHost;
+        std::string _connectPort;
+        // the last session ticket of the host, new connections resume it instead of full handshake
+        SSL_SESSION* _tlsSession;
+    };
+
+    template <class CompletionToken>
+    auto CAsyncHostDownloader::fetch(std::string_view target, CompletionToken&& token, const CCancellationToken& cancellationToken,
+        const CResponseCutoff& cutoff)
+    {
+        auto initiation = [this](auto handler, const std::string& target, const CCancellationToken& cancellationToken,
+                const CResponseCutoff& cutoff)
+            {
+                // completion handlers may be move only, but CompletionHandler must be copyable
+                auto ptrHandler = std::make_shared<decltype(handler)>(std::move(handler));
+                asyncDownload(target,
+                    [this, ptrHandler](const boost::system::error_code& errorCode, ResponseType&& response)
+                    {
+                        auto executor = boost::asio::get_associated_executor(*ptrHandler, _ioContext.get_executor());
+                        boost::asio::dispatch(executor,
+                            [ptrHandler, errorCode, response = std::move(response)]() mutable
+                            {
+                                (*ptrHandler)(errorCode, std::move(response));
+                            });
+                    },
+                    cancellationToken, cutoff);
+            };
+        return boost::asio::async_initiate<CompletionToken, void(boost::system::error_code, ResponseType)>(
+            initiation, token, std::string(target), cancellationToken, cutoff);
+    }
+}
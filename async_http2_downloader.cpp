@@ -0,0 +1,606 @@
+#include <boost/asio/post.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/version.hpp>
+#include <boost/beast/http/error.hpp>
+#include <charconv>
+#include <iterator>
+#include "async_http2_downloader.h"
+
+using namespace boost::asio;
+using namespace boost::beast;
+using namespace boost::system;
+
+namespace watchList
+{
+std::string_view CAsyncHttp2Downloader::ALPN_PROTOCOLS = "\x02h2";
+std::uint64_t CAsyncHttp2Downloader::MAX_BODY_SIZE = 8 * 1024 * 1024;
+std::size_t CAsyncHttp2Downloader::MAX_CONTENT_SIZE = 32 * 1024 * 1024;
+int CAsyncHttp2Downloader::MAX_ATTEMPTS = 2;
+std::int32_t CAsyncHttp2Downloader::CSession::STREAM_WINDOW_SIZE = 1024 * 1024;
+std::int32_t CAsyncHttp2Downloader::CSession::CONNECTION_WINDOW_SIZE = 16 * 1024 * 1024;
+std::uint32_t CAsyncHttp2Downloader::CSession::MAX_CONCURRENT_STREAMS = 100;
+
+static nghttp2_nv makeHeader(std::string_view name, std::string_view value)
+{
+    // nghttp2 copies names and values while request is submitted
+    return nghttp2_nv{ reinterpret_cast<std::uint8_t*>(const_cast<char*>(name.data())), reinterpret_cast<std::uint8_t*>(const_cast<char*>(value.data())),
+        name.size(), value.size(), NGHTTP2_NV_FLAG_NONE };
+}
+
+CAsyncHttp2Downloader::Request::Request(io_context& ioContext, std::string_view target, const CResponseCutoff& cutoff, CompletionHandler handler)
+    : target(target)
+    , cutoff(cutoff)
+    , handler(std::move(handler))
+    , timer(ioContext)
+    , streamId(-1)
+    , numAttempts(0)
+    , isHeaderReceived(false)
+    , isCompleted(false)
+    , bodySize(0)
+{
+}
+
+CAsyncHttp2Downloader::CSession::CSession(CAsyncHttp2Downloader* ptrDownloader)
+    : _ptrDownloader(ptrDownloader)
+    , _sslStream(ptrDownloader->_ioContext, ptrDownloader->_sslContext)
+    , _session(nullptr)
+    , _isConnecting(false)
+    , _isClosed(false)
+    , _isWriting(false)
+{
+    ptrDownloader->prepareStream(_sslStream);
+}
+
+CAsyncHttp2Downloader::CSession::~CSession()
+{
+    if (_session != nullptr)
+    {
+        nghttp2_session_del(_session);
+    }
+}
+
+void CAsyncHttp2Downloader::CSession::start()
+{
+    _isConnecting = true;
+    _ptrDownloader->connectStream(_sslStream,
+        [this, ptrThis = shared_from_this()](const error_code& errorCode)
+        {
+            onConnect(errorCode);
+        });
+}
+
+bool CAsyncHttp2Downloader::CSession::isRequestAllowed() const
+{
+    if (_isClosed)
+    {
+        return false;
+    }
+    return (_session == nullptr) ? _isConnecting : (nghttp2_session_check_request_allowed(_session) != 0);
+}
+
+void CAsyncHttp2Downloader::CSession::onConnect(const error_code& connectErrorCode)
+{
+    _isConnecting = false;
+    error_code errorCode = connectErrorCode;
+    if (!errorCode)
+    {
+        // streams have their own timeouts, connection stays open as long as server keeps it
+        get_lowest_layer(_sslStream).expires_never();
+
+        const unsigned char* protocol = nullptr;
+        unsigned int protocolSize = 0;
+        SSL_get0_alpn_selected(_sslStream.native_handle(), &protocol, &protocolSize);
+        if (std::string_view(reinterpret_cast<const char*>(protocol), protocolSize) != "h2")
+        {
+            errorCode = errc::make_error_code(errc::protocol_not_supported);
+        }
+        else if (!createSession())
+        {
+            errorCode = errc::make_error_code(errc::not_enough_memory);
+        }
+    }
+
+    if (errorCode)
+    {
+        close(errorCode);
+        return;
+    }
+
+    Request::List pendingRequests = std::move(_pendingRequests);
+    _pendingRequests.clear();
+    for (const Request::SharedPtr& request : pendingRequests)
+    {
+        submitRequest(request);
+    }
+    flush();
+    read();
+}
+
+bool CAsyncHttp2Downloader::CSession::createSession()
+{
+    nghttp2_session_callbacks* callbacks = nullptr;
+    if (nghttp2_session_callbacks_new(&callbacks) != 0)
+    {
+        return false;
+    }
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, onHeaderCallback);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, onFrameRecvCallback);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, onDataChunkRecvCallback);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, onStreamCloseCallback);
+    int result = nghttp2_session_client_new(&_session, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+    if (result != 0)
+    {
+        _session = nullptr;
+        return false;
+    }
+
+    // Every stream may have a whole page in flight, nghttp2 gives window back as soon as data is received.
+    // Connection window is shared by all streams, so it is bigger.
+    nghttp2_settings_entry settings[] =
+    {
+        { NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, MAX_CONCURRENT_STREAMS },
+        { NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, static_cast<std::uint32_t>(STREAM_WINDOW_SIZE) },
+        { NGHTTP2_SETTINGS_ENABLE_PUSH, 0 }
+    };
+    nghttp2_submit_settings(_session, NGHTTP2_FLAG_NONE, settings, std::size(settings));
+    nghttp2_session_set_local_window_size(_session, NGHTTP2_FLAG_NONE, 0, CONNECTION_WINDOW_SIZE);
+    return true;
+}
+
+void CAsyncHttp2Downloader::CSession::submit(Request::SharedPtr request)
+{
+    request->session = weak_from_this();
+    if (_session == nullptr)
+    {
+        _pendingRequests.push_back(std::move(request));
+    }
+    else
+    {
+        submitRequest(std::move(request));
+        flush();
+    }
+}
+
+void CAsyncHttp2Downloader::CSession::submitRequest(Request::SharedPtr request)
+{
+    // request could be cancelled while it waited for connection
+    if (request->isCompleted)
+    {
+        return;
+    }
+
+    std::string authority = (_ptrDownloader->_port == "443") ? _ptrDownloader->_host : _ptrDownloader->_host + ":" + _ptrDownloader->_port;
+    nghttp2_nv headers[] =
+    {
+        makeHeader(":method", "GET"),
+        makeHeader(":scheme", "https"),
+        makeHeader(":authority", authority),
+        makeHeader(":path", request->target),
+        makeHeader("user-agent", BOOST_BEAST_VERSION_STRING),
+        makeHeader("accept-encoding", CContentDecoder::getAcceptEncoding())
+    };
+    // streams above the limit of server are queued by nghttp2 itself
+    std::int32_t streamId = nghttp2_submit_request(_session, nullptr, headers, std::size(headers), nullptr, nullptr);
+    if (streamId < 0)
+    {
+        _ptrDownloader->completeRequest(request, errc::make_error_code(errc::protocol_error));
+        return;
+    }
+    request->streamId = streamId;
+    _streams[streamId] = request;
+    _ptrDownloader->startTimer(request, std::min(std::chrono::steady_clock::now() + _ptrDownloader->_timeouts.getFirstByte(), request->deadline));
+}
+
+CAsyncHttp2Downloader::Request::SharedPtr CAsyncHttp2Downloader::CSession::getRequest(std::int32_t streamId) const
+{
+    auto it = _streams.find(streamId);
+    return (it == _streams.end()) ? nullptr : it->second;
+}
+
+void CAsyncHttp2Downloader::CSession::cancelStream(Request::SharedPtr request, const error_code& errorCode)
+{
+    _ptrDownloader->completeRequest(request, errorCode);
+    if ((_session != nullptr) && (_streams.count(request->streamId) != 0))
+    {
+        // other streams and connection itself go on
+        nghttp2_submit_rst_stream(_session, NGHTTP2_FLAG_NONE, request->streamId, NGHTTP2_CANCEL);
+    }
+}
+
+void CAsyncHttp2Downloader::CSession::resetStream(Request::SharedPtr request, const error_code& errorCode)
+{
+    cancelStream(request, errorCode);
+    flush();
+}
+
+void CAsyncHttp2Downloader::CSession::read()
+{
+    _sslStream.async_read_some(buffer(_readBuffer),
+        [this, ptrThis = shared_from_this()](const error_code& errorCode, std::size_t numBytes)
+        {
+            onRead(errorCode, numBytes);
+        });
+}
+
+void CAsyncHttp2Downloader::CSession::onRead(const error_code& errorCode, std::size_t numBytes)
+{
+    if (_isClosed)
+    {
+        return;
+    }
+    if (errorCode)
+    {
+        close(errorCode);
+        return;
+    }
+
+    ssize_t result = nghttp2_session_mem_recv(_session, reinterpret_cast<const std::uint8_t*>(_readBuffer.data()), numBytes);
+    if (result < 0)
+    {
+        close(errc::make_error_code(errc::protocol_error));
+        return;
+    }
+    // received frames may need acknowledgement, reset streams wait for sending too
+    flush();
+    if (!_isClosed)
+    {
+        read();
+    }
+}
+
+void CAsyncHttp2Downloader::CSession::flush()
+{
+    if (_isWriting || _isClosed || (_session == nullptr))
+    {
+        return;
+    }
+
+    const std::uint8_t* data = nullptr;
+    ssize_t size = 0;
+    while ((size = nghttp2_session_mem_send(_session, &data)) > 0)
+    {
+        _writeBuffer.append(reinterpret_cast<const char*>(data), size);
+    }
+    if (size < 0)
+    {
+        close(errc::make_error_code(errc::protocol_error));
+        return;
+    }
+
+    if (_writeBuffer.empty())
+    {
+        // both sides have sent GOAWAY and all streams are finished
+        if ((nghttp2_session_want_read(_session) == 0) && (nghttp2_session_want_write(_session) == 0))
+        {
+            close(boost::asio::error::eof);
+        }
+        return;
+    }
+
+    _isWriting = true;
+    async_write(_sslStream, buffer(_writeBuffer),
+        [this, ptrThis = shared_from_this()](const error_code& errorCode, std::size_t)
+        {
+            _isWriting = false;
+            _writeBuffer.clear();
+            if (errorCode)
+            {
+                close(errorCode);
+            }
+            else
+            {
+                flush();
+            }
+        });
+}
+
+void CAsyncHttp2Downloader::CSession::close(const error_code& errorCode)
+{
+    if (_isClosed)
+    {
+        return;
+    }
+    _isClosed = true;
+
+    // downloader may hold the last reference
+    SharedPtr ptrThis = shared_from_this();
+    if (_ptrDownloader->_session == ptrThis)
+    {
+        _ptrDownloader->_session.reset();
+    }
+    error_code closeErrorCode;
+    get_lowest_layer(_sslStream).socket().close(closeErrorCode);
+
+    Request::List requests = std::move(_pendingRequests);
+    _pendingRequests.clear();
+    for (auto& stream : _streams)
+    {
+        requests.push_back(std::move(stream.second));
+    }
+    _streams.clear();
+
+    bool isConnected = (_session != nullptr);
+    for (const Request::SharedPtr& request : requests)
+    {
+        // server may drop idle connection at any moment, request which hasn't got response is repeated on a new one
+        if (request->isHeaderReceived)
+        {
+            _ptrDownloader->completeRequest(request, http::error::partial_message);
+        }
+        else if (!isConnected || !_ptrDownloader->retry(request))
+        {
+            _ptrDownloader->completeRequest(request, errorCode);
+        }
+    }
+}
+
+void CAsyncHttp2Downloader::CSession::onHeader(std::int32_t streamId, std::string_view name, std::string_view value)
+{
+    Request::SharedPtr request = getRequest(streamId);
+    if (request == nullptr)
+    {
+        return;
+    }
+
+    if (name == ":status")
+    {
+        unsigned status = 0;
+        std::from_chars(value.data(), value.data() + value.size(), status);
+        request->response.result(status);
+    }
+    else if (!name.empty() && (name[0] != ':'))
+    {
+        request->response.insert(name, value);
+    }
+}
+
+void CAsyncHttp2Downloader::CSession::onHeadersReceived(std::int32_t streamId)
+{
+    Request::SharedPtr request = getRequest(streamId);
+    if ((request == nullptr) || request->isCompleted)
+    {
+        return;
+    }
+
+    request->isHeaderReceived = true;
+    // unknown encoding is passed as is, server shouldn't use encodings which aren't accepted
+    request->decoder = CContentDecoder::create(request->response[http::field::content_encoding]);
+    _ptrDownloader->startTimer(request, request->deadline);
+}
+
+void CAsyncHttp2Downloader::CSession::onDataChunk(std::int32_t streamId, const std::uint8_t* data, std::size_t size)
+{
+    Request::SharedPtr request = getRequest(streamId);
+    if ((request == nullptr) || request->isCompleted)
+    {
+        return;
+    }
+
+    request->bodySize += size;
+    if (request->bodySize > MAX_BODY_SIZE)
+    {
+        cancelStream(request, http::error::body_limit);
+        return;
+    }
+
+    std::size_t checkedSize = request->content.size();
+    if (request->decoder == nullptr)
+    {
+        request->content.append(reinterpret_cast<const char*>(data), size);
+    }
+    else
+    {
+        try
+        {
+            request->decoder->decode(reinterpret_cast<const char*>(data), size, request->content, MAX_CONTENT_SIZE);
+        }
+        catch (const std::exception&)
+        {
+            cancelStream(request, errc::make_error_code(errc::bad_message));
+            return;
+        }
+    }
+
+    std::size_t contentEnd = request->cutoff.isEnabled() ? request->cutoff.findEnd(request->content, checkedSize) : std::string::npos;
+    if (contentEnd != std::string::npos)
+    {
+        request->content.resize(contentEnd);
+        cancelStream(request, error_code());
+    }
+}
+
+void CAsyncHttp2Downloader::CSession::onStreamClose(std::int32_t streamId, std::uint32_t errorCode)
+{
+    auto it = _streams.find(streamId);
+    if (it == _streams.end())
+    {
+        return;
+    }
+    Request::SharedPtr request = std::move(it->second);
+    _streams.erase(it);
+
+    if (request->isCompleted)
+    {
+        return;
+    }
+    if ((errorCode == NGHTTP2_NO_ERROR) && request->isHeaderReceived)
+    {
+        bool isFinished = (request->decoder == nullptr) || request->decoder->isFinished();
+        _ptrDownloader->completeRequest(request, isFinished ? error_code() : http::error::partial_message);
+    }
+    else if (request->isHeaderReceived)
+    {
+        _ptrDownloader->completeRequest(request, http::error::partial_message);
+    }
+    else if ((errorCode != NGHTTP2_REFUSED_STREAM) || !_ptrDownloader->retry(request))
+    {
+        // refused stream wasn't processed by server, so it is safe to repeat
+        _ptrDownloader->completeRequest(request, errc::make_error_code(errc::connection_reset));
+    }
+}
+
+int CAsyncHttp2Downloader::CSession::onHeaderCallback(nghttp2_session* /*session*/, const nghttp2_frame* frame, const std::uint8_t* name,
+    std::size_t nameSize, const std::uint8_t* value, std::size_t valueSize, std::uint8_t /*flags*/, void* userData)
+{
+    if ((frame->hd.type == NGHTTP2_HEADERS) && (frame->headers.cat == NGHTTP2_HCAT_RESPONSE))
+    {
+        CSession* ptrThis = static_cast<CSession*>(userData);
+        ptrThis->onHeader(frame->hd.stream_id, std::string_view(reinterpret_cast<const char*>(name), nameSize),
+            std::string_view(reinterpret_cast<const char*>(value), valueSize));
+    }
+    return 0;
+}
+
+int CAsyncHttp2Downloader::CSession::onFrameRecvCallback(nghttp2_session* /*session*/, const nghttp2_frame* frame, void* userData)
+{
+    if ((frame->hd.type == NGHTTP2_HEADERS) && (frame->headers.cat == NGHTTP2_HCAT_RESPONSE))
+    {
+        CSession* ptrThis = static_cast<CSession*>(userData);
+        ptrThis->onHeadersReceived(frame->hd.stream_id);
+    }
+    return 0;
+}
+
+int CAsyncHttp2Downloader::CSession::onDataChunkRecvCallback(nghttp2_session* /*session*/, std::uint8_t /*flags*/, std::int32_t streamId,
+    const std::uint8_t* data, std::size_t size, void* userData)
+{
+    CSession* ptrThis = static_cast<CSession*>(userData);
+    ptrThis->onDataChunk(streamId, data, size);
+    return 0;
+}
+
+int CAsyncHttp2Downloader::CSession::onStreamCloseCallback(nghttp2_session* /*session*/, std::int32_t streamId, std::uint32_t errorCode,
+    void* userData)
+{
+    CSession* ptrThis = static_cast<CSession*>(userData);
+    ptrThis->onStreamClose(streamId, errorCode);
+    return 0;
+}
+
+CAsyncHttp2Downloader::CAsyncHttp2Downloader(net::io_context& ioContext, CDnsCache& dnsCache, std::string_view host, std::string_view port,
+    const CDownloadTimeouts& timeouts)
+    : CAsyncHostDownloader(ioContext, dnsCache, host, port, timeouts)
+{
+    // only h2 is offered, host which doesn't support it is reported as error
+    SSL_CTX_set_alpn_protos(_sslContext.native_handle(), reinterpret_cast<const unsigned char*>(ALPN_PROTOCOLS.data()), ALPN_PROTOCOLS.size());
+}
+
+void CAsyncHttp2Downloader::submit(Request::SharedPtr request)
+{
+    if (request->isCompleted)
+    {
+        return;
+    }
+    ++request->numAttempts;
+    if ((_session == nullptr) || !_session->isRequestAllowed())
+    {
+        _session = std::make_shared<CSession>(this);
+        _session->start();
+    }
+    _session->submit(std::move(request));
+}
+
+bool CAsyncHttp2Downloader::retry(Request::SharedPtr request)
+{
+    if (request->numAttempts >= MAX_ATTEMPTS)
+    {
+        return false;
+    }
+    // first byte limit of the lost stream doesn't apply while new connection is opened
+    startTimer(request, request->deadline);
+    // retry may be asked from nghttp2 callback, where new requests can't be sent
+    post(_ioContext, [this, request]() { submit(request); });
+    return true;
+}
+
+void CAsyncHttp2Downloader::startTimer(Request::SharedPtr request, std::chrono::steady_clock::time_point expiryTime)
+{
+    request->timer.expires_at(expiryTime);
+    request->timer.async_wait(
+        [this, request](const error_code& errorCode)
+        {
+            if (!errorCode)
+            {
+                cancel(request, boost::beast::error::timeout);
+            }
+        });
+}
+
+void CAsyncHttp2Downloader::cancel(Request::SharedPtr request, const error_code& errorCode)
+{
+    if (request->isCompleted)
+    {
+        return;
+    }
+    if (auto ptrSession = request->session.lock())
+    {
+        ptrSession->resetStream(request, errorCode);
+    }
+    else
+    {
+        completeRequest(request, errorCode);
+    }
+}
+
+void CAsyncHttp2Downloader::completeRequest(Request::SharedPtr request, const error_code& errorCode)
+{
+    if (request->isCompleted)
+    {
+        return;
+    }
+    request->isCompleted = true;
+    request->timer.cancel();
+
+    ResponseType response;
+    if (!errorCode)
+    {
+        response = std::move(request->response);
+        response.version(20);
+        // headers describe decoded content
+        if (request->decoder != nullptr)
+        {
+            response.erase(http::field::content_encoding);
+        }
+        response.body() = std::move(request->content);
+        response.prepare_payload();
+    }
+    post(_ioContext,
+        [handler = std::move(request->handler), errorCode, response = std::move(response)]() mutable
+        {
+            handler(errorCode, std::move(response));
+        });
+}
+
+void CAsyncHttp2Downloader::asyncDownload(std::string_view target, CompletionHandler handler, const CCancellationToken& cancellationToken,
+    const CResponseCutoff& cutoff)
+{
+    auto request = std::make_shared<Request>(_ioContext, target, cutoff, std::move(handler));
+    request->deadline = std::chrono::steady_clock::now() + _timeouts.getTotal();
+    // token can be cancelled from any thread, request is touched only from io context
+    cancellationToken.subscribe(
+        [this, weakPtrRequest = std::weak_ptr<Request>(request)]()
+        {
+            post(_ioContext,
+                [this, weakPtrRequest]()
+                {
+                    if (auto request = weakPtrRequest.lock())
+                    {
+                        cancel(request, boost::asio::error::operation_aborted);
+                    }
+                });
+        });
+    // request may wait for connection, total limit runs from the start
+    startTimer(request, request->deadline);
+    submit(request);
+}
+
+void CAsyncHttp2Downloader::preconnect(int numConnections)
+{
+    if ((numConnections > 0) && ((_session == nullptr) || !_session->isRequestAllowed()))
+    {
+        _session = std::make_shared<CSession>(this);
+        _session->start();
+    }
+}
+}
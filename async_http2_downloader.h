@@ -0,0 +1,143 @@
+#pragma once
+
+#include <nghttp2/nghttp2.h>
+#include <boost/asio/steady_timer.hpp>
+#include <map>
+#include <list>
+#include <array>
+#include <string>
+#include <memory>
+#include <chrono>
+#include "content_decoder.h"
+#include "async_host_downloader.h"
+
+namespace watchList
+{
+    // Downloads pages from one host with HTTP/2, concurrent requests are multiplexed over one connection.
+    // Host must offer h2 through ALPN, downloads fail with protocol_not_supported error otherwise.
+    class CAsyncHttp2Downloader : public CAsyncHostDownloader
+    {
+    public:
+        CAsyncHttp2Downloader(boost::asio::io_context& ioContext, CDnsCache& dnsCache, std::string_view host, std::string_view port,
+            const CDownloadTimeouts& timeouts = CDownloadTimeouts());
+
+    public:
+        using CAsyncHostDownloader::asyncDownload;
+        // only the stream of request is reset when cutoff stops reading, connection is kept
+        void asyncDownload(std::string_view target, CompletionHandler handler, const CCancellationToken& cancellationToken = CCancellationToken(),
+            const CResponseCutoff& cutoff = CResponseCutoff()) override;
+
+        // all requests share one connection, so number of connections is ignored
+        void preconnect(int numConnections) override;
+
+    private:
+        class CSession;
+
+        struct Request
+        {
+            typedef std::shared_ptr<Request> SharedPtr;
+            typedef std::list<SharedPtr> List;
+
+            Request(boost::asio::io_context& ioContext, std::string_view target, const CResponseCutoff& cutoff, CompletionHandler handler);
+
+            std::string target;
+            CResponseCutoff cutoff;
+            CompletionHandler handler;
+            // first byte timeout until response header comes, total timeout after that
+            boost::asio::steady_timer timer;
+            std::chrono::steady_clock::time_point deadline;
+            std::weak_ptr<CSession> session;
+            std::int32_t streamId;
+            int numAttempts;
+            bool isHeaderReceived;
+            bool isCompleted;
+            ResponseType response;
+            CContentDecoder::UniquePtr decoder;
+            std::uint64_t bodySize;
+            std::string content;
+        };
+
+        // One connection with its nghttp2 session. Session which got GOAWAY or lost connection
+        // takes no more requests, new one is opened for them.
+        class CSession : public std::enable_shared_from_this<CSession>
+        {
+        public:
+            typedef std::shared_ptr<CSession> SharedPtr;
+
+        public:
+            CSession(CAsyncHttp2Downloader* ptrDownloader);
+            ~CSession();
+
+        public:
+            void start();
+            bool isRequestAllowed() const;
+            void submit(Request::SharedPtr request);
+            // completes request with error code and resets its stream
+            void resetStream(Request::SharedPtr request, const boost::system::error_code& errorCode);
+            Request::SharedPtr getRequest(std::int32_t streamId) const;
+
+        private:
+            typedef std::map<std::int32_t, Request::SharedPtr> Streams;
+
+        private:
+            static std::int32_t STREAM_WINDOW_SIZE;
+            static std::int32_t CONNECTION_WINDOW_SIZE;
+            static std::uint32_t MAX_CONCURRENT_STREAMS;
+
+        private:
+            void onConnect(const boost::system::error_code& errorCode);
+            bool createSession();
+            void submitRequest(Request::SharedPtr request);
+            // nghttp2 doesn't allow sending from its callbacks, so frames are flushed by the caller
+            void cancelStream(Request::SharedPtr request, const boost::system::error_code& errorCode);
+            void read();
+            void onRead(const boost::system::error_code& errorCode, std::size_t numBytes);
+            void flush();
+            void close(const boost::system::error_code& errorCode);
+
+            void onHeader(std::int32_t streamId, std::string_view name, std::string_view value);
+            void onHeadersReceived(std::int32_t streamId);
+            void onDataChunk(std::int32_t streamId, const std::uint8_t* data, std::size_t size);
+            void onStreamClose(std::int32_t streamId, std::uint32_t errorCode);
+
+            static int onHeaderCallback(nghttp2_session* session, const nghttp2_frame* frame, const std::uint8_t* name, std::size_t nameSize,
+                const std::uint8_t* value, std::size_t valueSize, std::uint8_t flags, void* userData);
+            static int onFrameRecvCallback(nghttp2_session* session, const nghttp2_frame* frame, void* userData);
+            static int onDataChunkRecvCallback(nghttp2_session* session, std::uint8_t flags, std::int32_t streamId, const std::uint8_t* data,
+                std::size_t size, void* userData);
+            static int onStreamCloseCallback(nghttp2_session* session, std::int32_t streamId, std::uint32_t errorCode, void* userData);
+
+        private:
+            CAsyncHttp2Downloader* _ptrDownloader;
+            SslStream _sslStream;
+            nghttp2_session* _session;
+            bool _isConnecting;
+            bool _isClosed;
+            bool _isWriting;
+            std::array<char, 16384> _readBuffer;
+            std::string _writeBuffer;
+            // requests which wait for connection
+            Request::List _pendingRequests;
+            Streams _streams;
+        };
+
+    private:
+        static std::string_view ALPN_PROTOCOLS;
+        static std::uint64_t MAX_BODY_SIZE;
+        static std::size_t MAX_CONTENT_SIZE;
+        static int MAX_ATTEMPTS;
+
+    private:
+        void submit(Request::SharedPtr request);
+        // request is repeated on a new connection when the old one has refused or lost it before response
+        bool retry(Request::SharedPtr request);
+        // request is reset with timeout error at expiry time, unless it is completed before
+        void startTimer(Request::SharedPtr request, std::chrono::steady_clock::time_point expiryTime);
+        void cancel(Request::SharedPtr request, const boost::system::error_code& errorCode);
+        // handler is called later, so it may start new downloads
+        void completeRequest(Request::SharedPtr request, const boost::system::error_code& errorCode);
+
+    private:
+        CSession::SharedPtr _session;
+    };
+}
@@ -3,6 +3,7 @@
 #include <boost/beast/version.hpp>
 #include <boost/beast/http/read.hpp>
 #include <boost/beast/http/write.hpp>
+#include <boost/asio/post.hpp>
 #include "yahoo_url_factory.h"
 #include "async_https_downloader.h"
 
@@ -12,103 +13,362 @@ using namespace boost::system;
 
 namespace watchList
 {
-CAsyncHttpsDownloader::CAsyncTask::CAsyncTask(CAsyncHttpsDownloader* ptrDownloader, std::string_view target)
-    : _request(http::verb::get, target, ptrDownloader->_version)
-    , _sslStream(ptrDownloader->_ioContext, ptrDownloader->_sslContext)
+std::size_t CAsyncHttpsDownloader::MAX_IDLE_CONNECTIONS = 8;
+std::size_t CAsyncHttpsDownloader::CAsyncTask::BODY_CHUNK_SIZE = 16384;
+std::uint64_t CAsyncHttpsDownloader::CAsyncTask::MAX_BODY_SIZE = 8 * 1024 * 1024;
+std::size_t CAsyncHttpsDownloader::CAsyncTask::MAX_CONTENT_SIZE = 32 * 1024 * 1024;
+std::uint64_t CAsyncHttpsDownloader::CAsyncTask::MAX_DRAIN_SIZE = 256 * 1024;
+std::chrono::seconds CAsyncHttpsDownloader::IDLE_CONNECTION_TIMEOUT(30);
+
+CAsyncHttpsDownloader::Connection::Connection(CAsyncHttpsDownloader* ptrDownloader)
+    : sslStream(ptrDownloader->_ioContext, ptrDownloader->_sslContext)
+    , isConnected(false)
+{
+    ptrDownloader->prepareStream(sslStream);
+}
+
+CAsyncHttpsDownloader::CAsyncTask::CAsyncTask(CAsyncHttpsDownloader* ptrDownloader, std::string_view target, const CResponseCutoff& cutoff,
+    CompletionHandler handler)
+    : _ptrDownloader(ptrDownloader)
+    , _request(http::verb::get, target, ptrDownloader->_version)
+    , _bodyChunk(BODY_CHUNK_SIZE)
+    , _cutoff(cutoff)
+    , _isCut(false)
+    , _drainedSize(0)
+    , _handler(std::move(handler))
+    , _connection(ptrDownloader->takeConnection())
+    , _isReusedConnection(_connection->isConnected)
+    , _isCancelled(false)
+    , _deadline(std::chrono::steady_clock::now() + ptrDownloader->_timeouts.getTotal())
 {
     _request.set(http::field::host, ptrDownloader->_host);
     _request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    _request.set(http::field::accept_encoding, CContentDecoder::getAcceptEncoding());
+    _request.keep_alive(true);
+    resetResponse();
+}
+
+void CAsyncHttpsDownloader::CAsyncTask::resetResponse()
+{
+    _parser.emplace();
+    _parser->body_limit(MAX_BODY_SIZE);
+    _decoder.reset();
+    _content.clear();
+    _isCut = false;
 }
 
 void CAsyncHttpsDownloader::CAsyncTask::onConnect(const error_code& errorCode)
 {
     if (validateErrorCode(errorCode))
     {
-        _sslStream.async_handshake(ssl::stream_base::client,
-            [this, ptrThis = shared_from_this()](const error_code& errorCode)
-            {
-                onHandshake(errorCode);
-            });
+        write();
     }
 }
 
-void CAsyncHttpsDownloader::CAsyncTask::onHandshake(const error_code& errorCode)
+void CAsyncHttpsDownloader::CAsyncTask::write()
+{
+    // limit covers both request and response header
+    get_lowest_layer(_connection->sslStream).expires_after(_ptrDownloader->_timeouts.getFirstByte());
+    http::async_write(_connection->sslStream, _request,
+        [this, ptrThis = shared_from_this()](const error_code& errorCode, std::size_t)
+        {
+            onWrite(errorCode);
+        });
+}
+
+void CAsyncHttpsDownloader::CAsyncTask::onWrite(const error_code& errorCode)
 {
     if (validateErrorCode(errorCode))
-    {       
-        http::async_write(_sslStream, _request,
+    {
+        http::async_read_header(_connection->sslStream, _connection->buffer, *_parser,
             [this, ptrThis = shared_from_this()](const error_code& errorCode, std::size_t)
             {
-                onWrite(errorCode);
+                onReadHeader(errorCode);
             });
     }
 }
 
-void CAsyncHttpsDownloader::CAsyncTask::onWrite(const error_code& errorCode)
+void CAsyncHttpsDownloader::CAsyncTask::onReadHeader(const error_code& errorCode)
 {
     if (validateErrorCode(errorCode))
     {
-        http::async_read(_sslStream, _buffer, _response,
-            [this, ptrThis = shared_from_this()](const error_code& errorCode, std::size_t)
-            {
-                onRead(errorCode);
-            });
+        // unknown encoding is passed as is, server shouldn't use encodings which aren't accepted
+        _decoder = CContentDecoder::create(_parser->get()[http::field::content_encoding]);
+        readBody();
+    }
+}
+
+void CAsyncHttpsDownloader::CAsyncTask::readBody()
+{
+    if (_parser->is_done())
+    {
+        completeResponse();
+        return;
     }
+
+    _parser->get().body().data = _bodyChunk.data();
+    _parser->get().body().size = _bodyChunk.size();
+    get_lowest_layer(_connection->sslStream).expires_at(_deadline);
+    http::async_read(_connection->sslStream, _connection->buffer, *_parser,
+        [this, ptrThis = shared_from_this()](const error_code& errorCode, std::size_t)
+        {
+            // full chunk buffer stops reading, it isn't an error
+            onReadBody((errorCode == http::error::need_buffer) ? error_code() : errorCode);
+        });
 }
 
-void CAsyncHttpsDownloader::CAsyncTask::onRead(const error_code& errorCode)
+void CAsyncHttpsDownloader::CAsyncTask::onReadBody(const error_code& errorCode)
 {
     if (validateErrorCode(errorCode))
     {
-        _promise.set_value(std::move(_response));
+        std::size_t chunkSize = _bodyChunk.size() - _parser->get().body().size;
+        std::size_t checkedSize = _content.size();
+        if (_decoder == nullptr)
+        {
+            _content.append(_bodyChunk.data(), chunkSize);
+        }
+        else
+        {
+            try
+            {
+                _decoder->decode(_bodyChunk.data(), chunkSize, _content, MAX_CONTENT_SIZE);
+            }
+            catch (const std::exception&)
+            {
+                // connection is dropped, rest of the body is never read from it
+                _handler(errc::make_error_code(errc::bad_message), ResponseType());
+                return;
+            }
+        }
+
+        std::size_t contentEnd = _cutoff.isEnabled() ? _cutoff.findEnd(_content, checkedSize) : std::string::npos;
+        if (contentEnd != std::string::npos)
+        {
+            _content.resize(contentEnd);
+            _isCut = true;
+            completeResponse();
+            return;
+        }
+        readBody();
+    }
+}
+
+void CAsyncHttpsDownloader::CAsyncTask::completeResponse()
+{
+    if (!_isCut && (_decoder != nullptr) && !_decoder->isFinished())
+    {
+        _handler(http::error::partial_message, ResponseType());
+        return;
     }
+
+    // unread rest of the body would be taken as the next response, so connection is reused only when it's read or drained
+    bool isConnectionReusable = _parser->is_done() && _parser->get().keep_alive();
+    bool isDraining = _isCut && !_parser->is_done() && _parser->get().keep_alive() && isRemainderSmall();
+    // parser goes on with the rest of cut body, so header is copied
+    ResponseType response(_parser->get().base());
+    if (isConnectionReusable)
+    {
+        _ptrDownloader->releaseConnection(std::move(_connection));
+    }
+    else if (_isCut && !isDraining)
+    {
+        error_code errorCode;
+        get_lowest_layer(_connection->sslStream).socket().close(errorCode);
+    }
+
+    // headers describe decoded content
+    if (_decoder != nullptr)
+    {
+        response.erase(http::field::content_encoding);
+    }
+    response.body() = std::move(_content);
+    response.prepare_payload();
+    _handler(error_code(), std::move(response));
+
+    if (isDraining)
+    {
+        // response is already handled, drain only keeps the connection for next requests
+        drainBody();
+    }
+}
+
+bool CAsyncHttpsDownloader::CAsyncTask::isRemainderSmall() const
+{
+    // chunked body of unknown size is drained until it's over the limit
+    boost::optional<std::uint64_t> remainingSize = _parser->content_length_remaining();
+    return !remainingSize || (*remainingSize <= MAX_DRAIN_SIZE);
 }
 
-bool CAsyncHttpsDownloader::CAsyncTask::validateErrorCode(const error_code& errorCode)
+void CAsyncHttpsDownloader::CAsyncTask::drainBody()
 {
+    if (_parser->is_done())
+    {
+        _ptrDownloader->releaseConnection(std::move(_connection));
+        return;
+    }
+
+    _parser->get().body().data = _bodyChunk.data();
+    _parser->get().body().size = _bodyChunk.size();
+    get_lowest_layer(_connection->sslStream).expires_at(_deadline);
+    http::async_read(_connection->sslStream, _connection->buffer, *_parser,
+        [this, ptrThis = shared_from_this()](const error_code& errorCode, std::size_t)
+        {
+            onDrainBody((errorCode == http::error::need_buffer) ? error_code() : errorCode);
+        });
+}
+
+void CAsyncHttpsDownloader::CAsyncTask::onDrainBody(const error_code& errorCode)
+{
+    _drainedSize += _bodyChunk.size() - _parser->get().body().size;
+    // handler has been called already, failed drain only loses the connection
+    if (errorCode || _isCancelled || (_drainedSize > MAX_DRAIN_SIZE))
+    {
+        error_code closeErrorCode;
+        get_lowest_layer(_connection->sslStream).socket().close(closeErrorCode);
+        return;
+    }
+    drainBody();
+}
+
+void CAsyncHttpsDownloader::CAsyncTask::cancel()
+{
+    _isCancelled = true;
+    if (_ptrConnectOperation != nullptr)
+    {
+        // resolve and connect don't run on the stream yet
+        _ptrConnectOperation->cancel();
+    }
+    if (_connection != nullptr)
+    {
+        // pending operation completes with error, connection isn't reused after that
+        get_lowest_layer(_connection->sslStream).cancel();
+    }
+}
+
+bool CAsyncHttpsDownloader::CAsyncTask::validateErrorCode(const error_code& operationErrorCode)
+{
+    // cancellation may come when operation has already succeeded
+    error_code errorCode = _isCancelled ? error_code(error::operation_aborted) : operationErrorCode;
     if (errorCode)
     {
-        try
+        // slow server won't answer faster on a new connection
+        if (_isReusedConnection && !_isCancelled && (errorCode != boost::beast::error::timeout))
         {
-            _promise.set_exception(std::make_exception_ptr(system_error(errorCode)));
+            _isReusedConnection = false;
+            // stale connection has taken time of the failed attempt, first byte limit is set again on write
+            _deadline = std::chrono::steady_clock::now() + _ptrDownloader->_timeouts.getTotal();
+            resetResponse();
+            _connection = std::make_shared<Connection>(_ptrDownloader);
+            run();
         }
-        catch (...)
+        else
         {
+            _handler(errorCode, ResponseType());
         }
         return false;
     }
     return true;
 }
 
-void CAsyncHttpsDownloader::CAsyncTask::run(const ip::tcp::resolver::results_type& resolveResults)
+void CAsyncHttpsDownloader::CAsyncTask::run()
 {
-    get_lowest_layer(_sslStream).async_connect(resolveResults, 
-        [this, ptrThis = shared_from_this()](const error_code& errorCode, const ip::tcp::endpoint&)
-        {
-            onConnect(errorCode);
-        });
+    if (_connection->isConnected)
+    {
+        write();
+    }
+    else
+    {
+        _ptrConnectOperation = _ptrDownloader->connect(_connection,
+            [this, ptrThis = shared_from_this()](const error_code& errorCode)
+            {
+                _ptrConnectOperation.reset();
+                onConnect(errorCode);
+            });
+    }
 }
 
-CAsyncHttpsDownloader::CAsyncTask::SharedPtr CAsyncHttpsDownloader::CAsyncTask::create(CAsyncHttpsDownloader* ptrDownloader, std::string_view target)
+CAsyncHttpsDownloader::CAsyncTask::SharedPtr CAsyncHttpsDownloader::CAsyncTask::create(CAsyncHttpsDownloader* ptrDownloader, std::string_view target,
+    const CResponseCutoff& cutoff, CompletionHandler handler)
 {
-    return std::make_shared<CAsyncHttpsDownloader::CAsyncTask>(ptrDownloader, target);
+    return std::make_shared<CAsyncHttpsDownloader::CAsyncTask>(ptrDownloader, target, cutoff, std::move(handler));
 }
 
-CAsyncHttpsDownloader::CAsyncHttpsDownloader(net::io_context& ioContext, std::string_view host, std::string_view port, int version)
-    : _ioContext(ioContext)
-    , _sslContext(ssl::context::tlsv12_client)
-    , _host(host)
-    , _port(port)
+CAsyncHttpsDownloader::CAsyncHttpsDownloader(net::io_context& ioContext, CDnsCache& dnsCache, std::string_view host, std::string_view port,
+    const CDownloadTimeouts& timeouts, int version)
+    : CAsyncHostDownloader(ioContext, dnsCache, host, port, timeouts)
     , _version(version)
 {
-    ip::tcp::resolver resolver(_ioContext);
-    _resolveResults = resolver.resolve(host, port);
 }
 
-CAsyncHttpsDownloader::FutureResponseType CAsyncHttpsDownloader::asyncDownload(std::string_view target)
+CAsyncHttpsDownloader::Connection::SharedPtr CAsyncHttpsDownloader::takeConnection()
+{
+    auto now = std::chrono::steady_clock::now();
+    while (!_idleConnections.empty())
+    {
+        Connection::SharedPtr connection = std::move(_idleConnections.back());
+        _idleConnections.pop_back();
+        // servers usually close keep-alive connections after several seconds of silence
+        if (now - connection->idleTime < IDLE_CONNECTION_TIMEOUT)
+        {
+            return connection;
+        }
+    }
+    return std::make_shared<Connection>(this);
+}
+
+void CAsyncHttpsDownloader::releaseConnection(Connection::SharedPtr connection)
+{
+    if (_idleConnections.size() < MAX_IDLE_CONNECTIONS)
+    {
+        get_lowest_layer(connection->sslStream).expires_never();
+        connection->idleTime = std::chrono::steady_clock::now();
+        _idleConnections.push_back(std::move(connection));
+    }
+}
+
+CAsyncHttpsDownloader::CConnectOperation::SharedPtr CAsyncHttpsDownloader::connect(Connection::SharedPtr connection, ConnectHandler handler)
+{
+    return connectStream(connection->sslStream,
+        [connection, handler = std::move(handler)](const error_code& errorCode)
+        {
+            connection->isConnected = !errorCode;
+            handler(errorCode);
+        });
+}
+
+void CAsyncHttpsDownloader::preconnect(int numConnections)
+{
+    for (int i = numConnections - static_cast<int>(_idleConnections.size()); i > 0; --i)
+    {
+        auto connection = std::make_shared<Connection>(this);
+        connect(connection,
+            [this, connection](const error_code& errorCode)
+            {
+                if (!errorCode)
+                {
+                    releaseConnection(connection);
+                }
+            });
+    }
+}
+
+void CAsyncHttpsDownloader::asyncDownload(std::string_view target, CompletionHandler handler, const CCancellationToken& cancellationToken,
+    const CResponseCutoff& cutoff)
 {
-    CAsyncTask::SharedPtr ptrTask = CAsyncTask::create(this, target);
-    ptrTask->run(_resolveResults);
-    return ptrTask->getPromise().get_future();
-}   
+    CAsyncTask::SharedPtr ptrTask = CAsyncTask::create(this, target, cutoff, std::move(handler));
+    // token can be cancelled from any thread, task is touched only from io context
+    cancellationToken.subscribe(
+        [this, weakPtrTask = std::weak_ptr<CAsyncTask>(ptrTask)]()
+        {
+            post(_ioContext,
+                [weakPtrTask]()
+                {
+                    if (auto ptrTask = weakPtrTask.lock())
+                    {
+                        ptrTask->cancel();
+                    }
+                });
+        });
+    ptrTask->run();
+}
 }
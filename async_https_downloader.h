@@ -1,73 +1,122 @@
 #pragma once
 
-#include <boost/asio/io_context.hpp>
-#include <boost/asio/ip/tcp.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
-#include <boost/beast/core/tcp_stream.hpp>
-#include <boost/beast/http/message.hpp>
-#include <boost/beast/http/dynamic_body.hpp>
-#include <boost/beast/http/string_body.hpp>
-#include <boost/beast/ssl/ssl_stream.hpp>
+#include <boost/beast/http/parser.hpp>
+#include <boost/beast/http/buffer_body.hpp>
 #include <string>
 #include <memory>
-#include <future>
+#include <vector>
+#include <chrono>
+#include <optional>
+#include "content_decoder.h"
+#include "async_host_downloader.h"
 
 namespace watchList
 {
-    class CAsyncHttpsDownloader
+    // Downloads pages from one host with HTTP/1.1 over pool of keep-alive connections.
+    class CAsyncHttpsDownloader : public CAsyncHostDownloader
     {   
     public:
-        typedef boost::beast::http::response<boost::beast::http::dynamic_body> ResponseType;
-        typedef std::future<ResponseType> FutureResponseType;
-        
-    public:
-        CAsyncHttpsDownloader(boost::asio::io_context& ioContext, std::string_view host, std::string_view port, int version = 11);
+        CAsyncHttpsDownloader(boost::asio::io_context& ioContext, CDnsCache& dnsCache, std::string_view host, std::string_view port,
+            const CDownloadTimeouts& timeouts = CDownloadTimeouts(), int version = 11);
     
     public:
-        FutureResponseType asyncDownload(std::string_view target);
+        using CAsyncHostDownloader::asyncDownload;
+        // connection is closed when cutoff stops reading in the middle of the body
+        void asyncDownload(std::string_view target, CompletionHandler handler, const CCancellationToken& cancellationToken = CCancellationToken(),
+            const CResponseCutoff& cutoff = CResponseCutoff()) override;
+
+        void preconnect(int numConnections) override;
         
     private:
+        struct Connection
+        {
+            typedef std::shared_ptr<Connection> SharedPtr;
+
+            Connection(CAsyncHttpsDownloader* ptrDownloader);
+
+            SslStream sslStream;
+            boost::beast::flat_buffer buffer;
+            bool isConnected;
+            std::chrono::steady_clock::time_point idleTime;
+        };
+
+        typedef std::vector<Connection::SharedPtr> ConnectionList;
+
         class CAsyncTask : public std::enable_shared_from_this<CAsyncTask>
         {
         public:
             typedef std::shared_ptr<CAsyncTask> SharedPtr;
             
         public:
-            CAsyncTask(CAsyncHttpsDownloader* ptrDownloader, std::string_view target);
+            CAsyncTask(CAsyncHttpsDownloader* ptrDownloader, std::string_view target, const CResponseCutoff& cutoff, CompletionHandler handler);
             
-            static SharedPtr create(CAsyncHttpsDownloader* ptrDownloader, std::string_view target);
+            static SharedPtr create(CAsyncHttpsDownloader* ptrDownloader, std::string_view target, const CResponseCutoff& cutoff, CompletionHandler handler);
             
         public:
-            void run(const boost::asio::ip::tcp::resolver::results_type& resolveResults);
-            
-            std::promise<ResponseType>& getPromise()
-                { return _promise; }
+            void run();
+            void cancel();
                 
         private:
             typedef boost::beast::http::request<boost::beast::http::string_body> RequestType;
+            // body is read into fixed buffer chunk by chunk and decoded right away
+            typedef boost::beast::http::response_parser<boost::beast::http::buffer_body> ResponseParserType;
+
+        private:
+            static std::size_t BODY_CHUNK_SIZE;
+            static std::uint64_t MAX_BODY_SIZE;
+            static std::size_t MAX_CONTENT_SIZE;
+            // rest of cut body up to this size is read out, so connection can be reused
+            static std::uint64_t MAX_DRAIN_SIZE;
 
         private:           
             void onConnect(const boost::system::error_code& errorCode);
-            void onHandshake(const boost::system::error_code& errorCode);
+            void write();
             void onWrite(const boost::system::error_code& errorCode);
-            void onRead(const boost::system::error_code& errorCode);
+            void onReadHeader(const boost::system::error_code& errorCode);
+            void readBody();
+            void onReadBody(const boost::system::error_code& errorCode);
+            void completeResponse();
+            bool isRemainderSmall() const;
+            void drainBody();
+            void onDrainBody(const boost::system::error_code& errorCode);
+            void resetResponse();
             
             bool validateErrorCode(const boost::system::error_code& errorCode);
 
         private:
-            boost::beast::flat_buffer _buffer;
+            CAsyncHttpsDownloader* _ptrDownloader;
             RequestType _request;
-            ResponseType _response;
-            std::promise<ResponseType> _promise;
-            boost::beast::ssl_stream<boost::beast::tcp_stream> _sslStream;
+            std::optional<ResponseParserType> _parser;
+            std::vector<char> _bodyChunk;
+            CContentDecoder::UniquePtr _decoder;
+            std::string _content;
+            CResponseCutoff _cutoff;
+            // the rest of the body is left unread
+            bool _isCut;
+            std::uint64_t _drainedSize;
+            CompletionHandler _handler;
+            Connection::SharedPtr _connection;
+            // resolve and connect of the new connection, cancellation aborts them
+            CConnectOperation::SharedPtr _ptrConnectOperation;
+            // server may close idle keep-alive connection at any moment, request is repeated on a new one then
+            bool _isReusedConnection;
+            bool _isCancelled;
+            // body must be received before this time
+            std::chrono::steady_clock::time_point _deadline;
         };
 
     private:
-        boost::asio::io_context& _ioContext;
-        boost::asio::ssl::context _sslContext;
-        boost::asio::ip::tcp::resolver::results_type _resolveResults;
-        std::string _host;
-        std::string _port;
+        static std::size_t MAX_IDLE_CONNECTIONS;
+        static std::chrono::seconds IDLE_CONNECTION_TIMEOUT;
+
+    private:
+        Connection::SharedPtr takeConnection();
+        void releaseConnection(Connection::SharedPtr connection);
+        CConnectOperation::SharedPtr connect(Connection::SharedPtr connection, ConnectHandler handler);
+
+    private:
         int _version;
+        ConnectionList _idleConnections;
     };
 }
@@ -0,0 +1,56 @@
+#include "cancellation_token.h"
+
+namespace watchList
+{
+CCancellationToken::CCancellationToken()
+    : _state(std::make_shared<State>())
+{
+}
+
+void CCancellationToken::cancel() const
+{
+    // callbacks may destroy the owner of this token
+    std::shared_ptr<State> state = _state;
+    std::map<SubscriptionId, Callback> callbacks;
+    {
+        std::unique_lock lock(state->mutex);
+        if (state->isCancelled)
+        {
+            return;
+        }
+        state->isCancelled = true;
+        callbacks.swap(state->callbacks);
+    }
+    for (const auto& [subscriptionId, callback] : callbacks)
+    {
+        callback();
+    }
+}
+
+bool CCancellationToken::isCancelled() const
+{
+    std::unique_lock lock(_state->mutex);
+    return _state->isCancelled;
+}
+
+CCancellationToken::SubscriptionId CCancellationToken::subscribe(Callback callback) const
+{
+    {
+        std::unique_lock lock(_state->mutex);
+        if (!_state->isCancelled)
+        {
+            SubscriptionId subscriptionId = ++_state->lastSubscriptionId;
+            _state->callbacks.emplace(subscriptionId, std::move(callback));
+            return subscriptionId;
+        }
+    }
+    callback();
+    return 0;
+}
+
+void CCancellationToken::unsubscribe(SubscriptionId subscriptionId) const
+{
+    std::unique_lock lock(_state->mutex);
+    _state->callbacks.erase(subscriptionId);
+}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <cstdint>
+#include <memory>
+#include <functional>
+
+namespace watchList
+{
+    // Copies of token share the same state, so download can be cancelled through any of them from any thread
+    class CCancellationToken
+    {
+    public:
+        typedef std::function<void()> Callback;
+        // 0 is never given to subscription
+        typedef std::uint64_t SubscriptionId;
+
+    public:
+        CCancellationToken();
+
+    public:
+        void cancel() const;
+        bool isCancelled() const;
+
+        // callback is called once from the thread which cancels the token, or right away if it is already cancelled
+        SubscriptionId subscribe(Callback callback) const;
+        // callback of long living token is dropped when its download is over, it isn't called after that
+        void unsubscribe(SubscriptionId subscriptionId) const;
+
+    private:
+        struct State
+        {
+            std::mutex mutex;
+            bool isCancelled = false;
+            SubscriptionId lastSubscriptionId = 0;
+            std::map<SubscriptionId, Callback> callbacks;
+        };
+
+    private:
+        std::shared_ptr<State> _state;
+    };
+}
@@ -1,5 +1,6 @@
 #include "app_settings.h"
 #include "cmd_line_params_parser.h"
+#include <algorithm>
 #include <filesystem>
 
 namespace watchList
@@ -8,10 +9,20 @@ CCmdLineParamsParser::CCmdLineParamsParser(int argCount, char ** argValues)
     : _isWatchDiskunion(false)
     , _isContinueLastSession(false)
     , _isWatchYahoo(true)
+    , _isDaemon(false)
+    , _isWatchFiles(false)
+    , _isYahooCategoryFeed(false)
+    , _yahooPollIntervalMinutes(15)
+    , _diskunionPollIntervalMinutes(60)
     , _yahooKeywordsFilePath(DATA_DIR + YAHOO_KEYWORDS_DEFAULT_FILE_NAME)
     , _diskunionItemsFilePath(DATA_DIR + DISKUNION_ITEMS_DEFAULT_FILE_NAME)
+    , _downloadHostsFilePath(DATA_DIR + DOWNLOAD_HOSTS_DEFAULT_FILE_NAME)
 {
     parse(argCount, argValues);
+    if (std::filesystem::exists(_downloadHostsFilePath))
+    {
+        _downloaderSettings.loadHostRateLimits(_downloadHostsFilePath);
+    }
 }
 
 bool CCmdLineParamsParser::parseFileName(int argCount, char** argValues, int* argNum, std::string* fileName)
@@ -36,6 +47,58 @@ bool CCmdLineParamsParser::parseFileName(int argCount, char** argValues, int* ar
     return false;
 }
 
+bool CCmdLineParamsParser::parseNumber(int argCount, char** argValues, int* argNum, int* number)
+{
+    int argNumNext = *argNum + 1;
+    if (argNumNext < argCount)
+    {
+        try
+        {
+            *number = std::stoi(argValues[argNumNext]);
+            *argNum = argNumNext;
+            return true;
+        }
+        catch (const std::logic_error&)
+        {
+        }
+    }
+    return false;
+}
+
+bool CCmdLineParamsParser::parseCount(int argCount, char** argValues, int* argNum, int* count)
+{
+    if (parseNumber(argCount, argValues, argNum, count))
+    {
+        // downloader without workers or host slots would wait forever, daemon without interval would poll without a break
+        *count = std::max(*count, 1);
+        return true;
+    }
+    return false;
+}
+
+bool CCmdLineParamsParser::parseNumber(int argCount, char** argValues, int* argNum, int minNumber, int* number)
+{
+    int parsedNumber = 0;
+    if (parseNumber(argCount, argValues, argNum, &parsedNumber) && (parsedNumber >= minNumber))
+    {
+        *number = parsedNumber;
+        return true;
+    }
+    return false;
+}
+
+bool CCmdLineParamsParser::parseTimeout(int argCount, char** argValues, int* argNum, CDownloadTimeouts::Duration* timeout)
+{
+    int timeoutMs = 0;
+    // zero timeout would fail every download at once
+    if (parseNumber(argCount, argValues, argNum, 1, &timeoutMs))
+    {
+        *timeout = CDownloadTimeouts::Duration(timeoutMs);
+        return true;
+    }
+    return false;
+}
+
 void CCmdLineParamsParser::parse(int argCount, char** argValues)
 {
     for (int argNum = 1; argNum < argCount; ++argNum)
@@ -45,6 +108,44 @@ void CCmdLineParamsParser::parse(int argCount, char** argValues)
         {   
             parseFileName(argCount, argValues, &argNum, &_yahooKeywordsFilePath);
         }
+        else if (argValue == "--hosts")
+        {
+            parseFileName(argCount, argValues, &argNum, &_downloadHostsFilePath);
+        }
+        else if (argValue == "--throttle-log")
+        {
+            parseFileName(argCount, argValues, &argNum, &_downloaderSettings._throttleLogFilePath);
+        }
+        else if (argValue == "--record")
+        {
+            int argNumNext = argNum + 1;
+            if ((argNumNext < argCount) && (argValues[argNumNext][0] != '-'))
+            {
+                _downloaderSettings._recordDirPath = argValues[argNumNext];
+                argNum = argNumNext;
+            }
+        }
+        else if (argValue == "--replay")
+        {
+            int argNumNext = argNum + 1;
+            if ((argNumNext < argCount) && (argValues[argNumNext][0] != '-'))
+            {
+                _downloaderSettings._replayAddress = argValues[argNumNext];
+                // web engine would go to the real hosts
+                _downloaderSettings._backend = EDownloadBackend::HTTPS;
+                argNum = argNumNext;
+            }
+        }
+        else if (argValue == "--http2")
+        {
+            // option can be repeated for several hosts
+            int argNumNext = argNum + 1;
+            if ((argNumNext < argCount) && (argValues[argNumNext][0] != '-'))
+            {
+                _downloaderSettings._http2Hosts.emplace(argValues[argNumNext]);
+                argNum = argNumNext;
+            }
+        }
         else 
         {
             bool isParseFileName = true;
@@ -62,7 +163,88 @@ void CCmdLineParamsParser::parse(int argCount, char** argValues)
                 isParseFileName = false;
                 if (argValue == "--continue")
                 {
+                    // session started with --continue can be continued as well
                     _isContinueLastSession = true;
+                    _downloaderSettings._isKeepDownloads = true;
+                }
+                else if (argValue == "--daemon")
+                {
+                    _isDaemon = true;
+                }
+                else if (argValue == "--watch")
+                {
+                    // queries files are only reloaded between cycles of daemon
+                    _isDaemon = true;
+                    _isWatchFiles = true;
+                }
+                else if (argValue == "--yahoo-feed")
+                {
+                    _isYahooCategoryFeed = true;
+                }
+                else if (argValue == "--yahoo-interval")
+                {
+                    parseCount(argCount, argValues, &argNum, &_yahooPollIntervalMinutes);
+                }
+                else if (argValue == "--diskunion-interval")
+                {
+                    parseCount(argCount, argValues, &argNum, &_diskunionPollIntervalMinutes);
+                }
+                else if (argValue == "--keep-downloads")
+                {
+                    _downloaderSettings._isKeepDownloads = true;
+                }
+                else if (argValue == "--webkit")
+                {
+                    _downloaderSettings._backend = EDownloadBackend::WEB_KIT;
+                }
+                else if (argValue == "--https-only")
+                {
+                    _downloaderSettings._backend = EDownloadBackend::HTTPS;
+                }
+                else if (argValue == "--fixed-rate")
+                {
+                    _downloaderSettings._isAdaptiveRate = false;
+                }
+                else if (argValue == "--preconnect")
+                {
+                    _downloaderSettings._isPreconnect = true;
+                }
+                else if (argValue == "--workers")
+                {
+                    parseCount(argCount, argValues, &argNum, &_downloaderSettings._numWorkers);
+                }
+                else if (argValue == "--max-per-host")
+                {
+                    parseCount(argCount, argValues, &argNum, &_downloaderSettings._maxTasksPerHost);
+                }
+                else if (argValue == "--max-attempts")
+                {
+                    parseCount(argCount, argValues, &argNum, &_downloaderSettings._maxAttempts);
+                }
+                else if (argValue == "--retry-delay")
+                {
+                    parseNumber(argCount, argValues, &argNum, 0, &_downloaderSettings._retryDelayMs);
+                }
+                else if (argValue == "--timeout")
+                {
+                    parseTimeout(argCount, argValues, &argNum, &_downloaderSettings._timeouts._total);
+                }
+                else if (argValue == "--connect-timeout")
+                {
+                    parseTimeout(argCount, argValues, &argNum, &_downloaderSettings._timeouts._connect);
+                }
+                else if (argValue == "--handshake-timeout")
+                {
+                    parseTimeout(argCount, argValues, &argNum, &_downloaderSettings._timeouts._handshake);
+                }
+                else if (argValue == "--first-byte-timeout")
+                {
+                    parseTimeout(argCount, argValues, &argNum, &_downloaderSettings._timeouts._firstByte);
+                }
+                else if (argValue == "--max-page-size")
+                {
+                    // 0 keeps pages unlimited
+                    parseNumber(argCount, argValues, &argNum, 0, &_downloaderSettings._maxPageSizeKb);
                 }
             }
             if (isParseFileName)
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <chrono>
+#include "downloader_settings.h"
 
 namespace watchList
 {
@@ -18,6 +20,27 @@ namespace watchList
             
         bool isWatchYahoo() const
             { return _isWatchYahoo; }            
+
+        // watchlists are polled until SIGINT or SIGTERM, downloader and watch history stay in memory
+        bool isDaemon() const
+            { return _isDaemon; }
+
+        // daemon reloads queries files when they are changed
+        bool isWatchFiles() const
+            { return _isWatchFiles; }
+
+        // newest auctions of categories are matched against all keywords instead of search of each keyword
+        bool isYahooCategoryFeed() const
+            { return _isYahooCategoryFeed; }
+
+        std::chrono::minutes getYahooPollInterval() const
+            { return std::chrono::minutes(_yahooPollIntervalMinutes); }
+
+        std::chrono::minutes getDiskunionPollInterval() const
+            { return std::chrono::minutes(_diskunionPollIntervalMinutes); }
+            
+        const CDownloaderSettings& getDownloaderSettings() const
+            { return _downloaderSettings; }
             
         const std::string& getYahooKeywordsFilePath() const
             { return _yahooKeywordsFilePath; }
@@ -28,12 +51,25 @@ namespace watchList
     private:
         void parse(int argCount, char** argValues);
         bool parseFileName(int argCount, char** argValues, int* argNum, std::string* fileName);
+        bool parseNumber(int argCount, char** argValues, int* argNum, int* number);
+        // number below minimum is rejected, default value stays
+        bool parseNumber(int argCount, char** argValues, int* argNum, int minNumber, int* number);
+        // count is at least 1
+        bool parseCount(int argCount, char** argValues, int* argNum, int* count);
+        bool parseTimeout(int argCount, char** argValues, int* argNum, CDownloadTimeouts::Duration* timeout);
 
     private:
         bool _isWatchDiskunion;
         bool _isContinueLastSession;
         bool _isWatchYahoo;
+        bool _isDaemon;
+        bool _isWatchFiles;
+        bool _isYahooCategoryFeed;
+        int _yahooPollIntervalMinutes;
+        int _diskunionPollIntervalMinutes;
+        CDownloaderSettings _downloaderSettings;
         std::string _yahooKeywordsFilePath;
         std::string _diskunionItemsFilePath;
+        std::string _downloadHostsFilePath;
     };
 }
@@ -0,0 +1,201 @@
+#include <zlib.h>
+#include <brotli/decode.h>
+#include <string>
+#include <stdexcept>
+#include "content_decoder.h"
+
+namespace watchList
+{
+static std::string_view GZIP_CONTENT_ENCODING_STR = "gzip";
+static std::string_view DEFLATE_CONTENT_ENCODING_STR = "deflate";
+static std::string_view BROTLI_CONTENT_ENCODING_STR = "br";
+static std::string_view ACCEPT_ENCODING_STR = "gzip, deflate, br";
+
+// output is decoded through buffer of fixed size, so memory grows only with the decoded page
+static const std::size_t DECODE_BUFFER_SIZE = 16384;
+
+static void appendDecoded(const char* data, std::size_t size, std::string& content, std::size_t maxContentSize)
+{
+    if (content.size() + size > maxContentSize)
+    {
+        throw std::runtime_error("decoded content is too large");
+    }
+    content.append(data, size);
+}
+
+class CZlibContentDecoder : public CContentDecoder
+{
+public:
+    CZlibContentDecoder();
+    ~CZlibContentDecoder();
+
+public:
+    void decode(const char* data, std::size_t size, std::string& content, std::size_t maxContentSize) override;
+
+    bool isFinished() const override
+        { return _isFinished; }
+
+private:
+    static bool isWrappedStream(std::string_view header);
+
+    void init(int windowBits);
+    void decodeChunk(const char* data, std::size_t size, std::string& content, std::size_t maxContentSize);
+
+private:
+    z_stream _stream;
+    bool _isFinished;
+    bool _isStarted;
+    // the first bytes until stream format can be told from them
+    std::string _header;
+};
+
+CZlibContentDecoder::CZlibContentDecoder()
+    : _stream()
+    , _isFinished(false)
+    , _isStarted(false)
+{
+    // gzip and zlib headers are detected automatically
+    init(MAX_WBITS + 32);
+}
+
+CZlibContentDecoder::~CZlibContentDecoder()
+{
+    inflateEnd(&_stream);
+}
+
+void CZlibContentDecoder::init(int windowBits)
+{
+    if (inflateInit2(&_stream, windowBits) != Z_OK)
+    {
+        throw std::runtime_error("can't initialize zlib");
+    }
+}
+
+bool CZlibContentDecoder::isWrappedStream(std::string_view header)
+{
+    auto first = static_cast<unsigned char>(header[0]);
+    auto second = static_cast<unsigned char>(header[1]);
+    bool isGzip = (first == 0x1F) && (second == 0x8B);
+    // deflate method and check bits of RFC 1950 header
+    bool isZlib = ((first & 0x0F) == Z_DEFLATED) && (((first << 8) | second) % 31 == 0);
+    return isGzip || isZlib;
+}
+
+void CZlibContentDecoder::decode(const char* data, std::size_t size, std::string& content, std::size_t maxContentSize)
+{
+    if (_isStarted)
+    {
+        decodeChunk(data, size, content, maxContentSize);
+        return;
+    }
+
+    // body may come byte by byte, format is chosen only when the whole header has arrived
+    _header.append(data, size);
+    if (_header.size() < 2)
+    {
+        return;
+    }
+    _isStarted = true;
+    if (!isWrappedStream(_header))
+    {
+        // some servers send raw deflate stream without zlib header
+        inflateEnd(&_stream);
+        init(-MAX_WBITS);
+    }
+    std::string header = std::move(_header);
+    _header.clear();
+    decodeChunk(header.data(), header.size(), content, maxContentSize);
+}
+
+void CZlibContentDecoder::decodeChunk(const char* data, std::size_t size, std::string& content, std::size_t maxContentSize)
+{
+    char buffer[DECODE_BUFFER_SIZE];
+    _stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    _stream.avail_in = static_cast<uInt>(size);
+    bool hasOutput = true;
+    while (hasOutput && !_isFinished)
+    {
+        _stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        _stream.avail_out = sizeof(buffer);
+        int result = inflate(&_stream, Z_NO_FLUSH);
+        if ((result != Z_OK) && (result != Z_STREAM_END) && (result != Z_BUF_ERROR))
+        {
+            throw std::runtime_error("can't decode content : " + std::string(_stream.msg == nullptr ? "zlib error" : _stream.msg));
+        }
+        _isFinished = (result == Z_STREAM_END);
+        appendDecoded(buffer, sizeof(buffer) - _stream.avail_out, content, maxContentSize);
+        // full buffer means zlib may keep more output even when the whole input is consumed
+        hasOutput = (_stream.avail_in > 0) || (_stream.avail_out == 0);
+    }
+}
+
+class CBrotliContentDecoder : public CContentDecoder
+{
+public:
+    CBrotliContentDecoder();
+    ~CBrotliContentDecoder();
+
+public:
+    void decode(const char* data, std::size_t size, std::string& content, std::size_t maxContentSize) override;
+
+    bool isFinished() const override
+        { return _isFinished; }
+
+private:
+    BrotliDecoderState* _state;
+    bool _isFinished;
+};
+
+CBrotliContentDecoder::CBrotliContentDecoder()
+    : _state(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr))
+    , _isFinished(false)
+{
+    if (_state == nullptr)
+    {
+        throw std::runtime_error("can't initialize brotli");
+    }
+}
+
+CBrotliContentDecoder::~CBrotliContentDecoder()
+{
+    BrotliDecoderDestroyInstance(_state);
+}
+
+void CBrotliContentDecoder::decode(const char* data, std::size_t size, std::string& content, std::size_t maxContentSize)
+{
+    char buffer[DECODE_BUFFER_SIZE];
+    const uint8_t* nextIn = reinterpret_cast<const uint8_t*>(data);
+    std::size_t availableIn = size;
+    BrotliDecoderResult result = BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT;
+    while (result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT)
+    {
+        uint8_t* nextOut = reinterpret_cast<uint8_t*>(buffer);
+        std::size_t availableOut = sizeof(buffer);
+        result = BrotliDecoderDecompressStream(_state, &availableIn, &nextIn, &availableOut, &nextOut, nullptr);
+        if (result == BROTLI_DECODER_RESULT_ERROR)
+        {
+            throw std::runtime_error("can't decode content : " + std::string(BrotliDecoderErrorString(BrotliDecoderGetErrorCode(_state))));
+        }
+        appendDecoded(buffer, sizeof(buffer) - availableOut, content, maxContentSize);
+    }
+    _isFinished = (result == BROTLI_DECODER_RESULT_SUCCESS);
+}
+
+CContentDecoder::UniquePtr CContentDecoder::create(std::string_view contentEncoding)
+{
+    if ((contentEncoding == GZIP_CONTENT_ENCODING_STR) || (contentEncoding == DEFLATE_CONTENT_ENCODING_STR))
+    {
+        return std::make_unique<CZlibContentDecoder>();
+    }
+    else if (contentEncoding == BROTLI_CONTENT_ENCODING_STR)
+    {
+        return std::make_unique<CBrotliContentDecoder>();
+    }
+    return nullptr;
+}
+
+std::string_view CContentDecoder::getAcceptEncoding()
+{
+    return ACCEPT_ENCODING_STR;
+}
+}
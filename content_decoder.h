@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace watchList
+{
+    // Decompresses body of the response chunk by chunk as it comes from the server
+    class CContentDecoder
+    {
+    public:
+        typedef std::unique_ptr<CContentDecoder> UniquePtr;
+
+    public:
+        virtual ~CContentDecoder() = default;
+
+        // null if content isn't encoded or encoding isn't supported
+        static UniquePtr create(std::string_view contentEncoding);
+
+        // value of Accept-Encoding header listing all supported encodings
+        static std::string_view getAcceptEncoding();
+
+    public:
+        // decoded data is appended to content, throws if data is corrupted or content gets bigger than maxContentSize
+        virtual void decode(const char* data, std::size_t size, std::string& content, std::size_t maxContentSize) = 0;
+
+        // true when the whole compressed stream is decoded
+        virtual bool isFinished() const = 0;
+    };
+}
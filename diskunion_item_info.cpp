@@ -22,6 +22,7 @@ std::string_view CDiskunionItemInfoHtmlParser::LIST_OPEN_TAG = "<li>";
 std::string_view CDiskunionItemInfoHtmlParser::LIST_CLOSE_TAG = "</li>";
 std::string_view CDiskunionItemInfoHtmlParser::META_IMAGE_PROPERTY_TAG = "<meta property=\"og:image\"";
 std::string_view CDiskunionItemInfoHtmlParser::CONTENT_ATTRIBUTE = "content";
+std::string_view CDiskunionItemInfoHtmlParser::FOOTER_OPEN_TAG = "<footer";
 
 CDiskunionItemDescription::CDiskunionItemDescription()
     : _isProblemItem(false)
@@ -37,13 +38,25 @@ CDiskunionItemInfo::CDiskunionItemInfo(const CDiskunionItemInfoHtmlParser& parse
 {
 }
 
-CDiskunionItemInfoHtmlParser::CDiskunionItemInfoHtmlParser(const std::stringstream& response)
-    : _content(response)
+CDiskunionItemInfoHtmlParser::CDiskunionItemInfoHtmlParser(std::string&& response)
+    : _content(std::move(response))
 {
     _parser = _content.createParser();
+    // footer is the end anchor of both parser and response cutoff, so cut and full pages give the same items
+    CHtmlParser parserBeforeFooter = _parser;
+    parserBeforeFooter.skipEnding(FOOTER_OPEN_TAG);
+    if (parserBeforeFooter.hasContent())
+    {
+        _parser = parserBeforeFooter;
+    }
     parseItemInfo();
 }
 
+CResponseCutoff CDiskunionItemInfoHtmlParser::getResponseCutoff()
+{
+    return CResponseCutoff(FOOTER_OPEN_TAG);
+}
+
 std::string_view CDiskunionItemInfoHtmlParser::getLabel() const
 {
     std::string_view label = getItemInfoValue(LABEL_TAG);
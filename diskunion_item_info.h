@@ -101,7 +101,7 @@ namespace watchList
     class CDiskunionItemInfoHtmlParser
     {
     public:
-        CDiskunionItemInfoHtmlParser(const std::stringstream& response);
+        CDiskunionItemInfoHtmlParser(std::string&& response);
         
     public:
         bool hasNextUsedItem();
@@ -111,6 +111,9 @@ namespace watchList
             
         const CDiskunionItemDescription& getItemDescription() const
             { return _itemDescription; }
+
+        // spec and used items are looked for only before page footer, so footer and the rest of the page aren't downloaded
+        static CResponseCutoff getResponseCutoff();
             
     private:
         void parseItemInfo();
@@ -142,6 +145,7 @@ namespace watchList
         static std::string_view LIST_CLOSE_TAG;
         static std::string_view META_IMAGE_PROPERTY_TAG;
         static std::string_view CONTENT_ATTRIBUTE;
+        static std::string_view FOOTER_OPEN_TAG;
             
     private:
         CDiskunionItemDescription _itemDescription;
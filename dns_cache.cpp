@@ -0,0 +1,67 @@
+#include <boost/asio/post.hpp>
+#include "dns_cache.h"
+
+using namespace boost::asio;
+using namespace boost::system;
+
+namespace watchList
+{
+CDnsCache::CDnsCache(io_context& ioContext, Clock::duration timeToLive)
+    : _ioContext(ioContext)
+    , _resolver(ioContext)
+    , _timeToLive(timeToLive)
+{
+}
+
+void CDnsCache::asyncResolve(const std::string& host, const std::string& port, ResolveHandler handler)
+{
+    std::string key = host + ":" + port;
+    Entry& entry = _entries[key];
+    if (!entry.results.empty() && (Clock::now() < entry.expiryTime))
+    {
+        // handler is never called before asyncResolve returns
+        post(_ioContext, [handler = std::move(handler), results = entry.results]() { handler(error_code(), results); });
+        return;
+    }
+
+    entry.handlers.push_back(std::move(handler));
+    if (!entry.isResolving)
+    {
+        entry.isResolving = true;
+        _resolver.async_resolve(host, port,
+            [this, key](const error_code& errorCode, const ResolveResults& results)
+            {
+                onResolve(key, errorCode, results);
+            });
+    }
+}
+
+void CDnsCache::onResolve(const std::string& key, const error_code& errorCode, const ResolveResults& results)
+{
+    Entry& entry = _entries[key];
+    entry.isResolving = false;
+    if (!errorCode)
+    {
+        entry.results = results;
+        entry.expiryTime = Clock::now() + _timeToLive;
+    }
+
+    // expired addresses are still better than nothing when resolver fails
+    error_code resultErrorCode = entry.results.empty() ? errorCode : error_code();
+    std::vector<ResolveHandler> handlers = std::move(entry.handlers);
+    entry.handlers.clear();
+    for (const ResolveHandler& handler : handlers)
+    {
+        handler(resultErrorCode, entry.results);
+    }
+}
+
+void CDnsCache::invalidate(const std::string& host, const std::string& port)
+{
+    auto it = _entries.find(host + ":" + port);
+    if (it != _entries.end())
+    {
+        it->second.expiryTime = Clock::time_point();
+    }
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <functional>
+
+namespace watchList
+{
+    // Resolves host names asynchronously and keeps results for a while, so connections don't wait for DNS.
+    // Must be used only from io context thread.
+    class CDnsCache
+    {
+    public:
+        typedef boost::asio::ip::tcp::resolver::results_type ResolveResults;
+        typedef std::function<void(const boost::system::error_code& errorCode, const ResolveResults& results)> ResolveHandler;
+        typedef std::chrono::steady_clock Clock;
+
+    public:
+        CDnsCache(boost::asio::io_context& ioContext, Clock::duration timeToLive = std::chrono::seconds(60));
+
+    public:
+        void asyncResolve(const std::string& host, const std::string& port, ResolveHandler handler);
+
+        // next request resolves host again, e.g. when none of its addresses answers
+        void invalidate(const std::string& host, const std::string& port);
+
+    private:
+        struct Entry
+        {
+            ResolveResults results;
+            Clock::time_point expiryTime;
+            bool isResolving = false;
+            // requests which came while host is being resolved
+            std::vector<ResolveHandler> handlers;
+        };
+
+        typedef std::map<std::string, Entry> Entries;
+
+    private:
+        void onResolve(const std::string& key, const boost::system::error_code& errorCode, const ResolveResults& results);
+
+    private:
+        boost::asio::io_context& _ioContext;
+        boost::asio::ip::tcp::resolver _resolver;
+        Clock::duration _timeToLive;
+        Entries _entries;
+    };
+}
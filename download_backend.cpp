@@ -0,0 +1,66 @@
+#include "download_backend.h"
+
+namespace watchList
+{
+static std::string_view NONE_DOWNLOAD_FAILURE_STR = "none";
+static std::string_view TRANSIENT_DOWNLOAD_FAILURE_STR = "transient";
+static std::string_view THROTTLED_DOWNLOAD_FAILURE_STR = "throttled";
+static std::string_view HARD_DOWNLOAD_FAILURE_STR = "hard";
+static std::string_view TRUNCATED_DOWNLOAD_FAILURE_STR = "truncated";
+
+std::string_view getDownloadFailure(EDownloadFailure failure)
+{
+    switch (failure)
+    {
+        case EDownloadFailure::NONE:
+            return NONE_DOWNLOAD_FAILURE_STR;
+        case EDownloadFailure::TRANSIENT:
+            return TRANSIENT_DOWNLOAD_FAILURE_STR;
+        case EDownloadFailure::THROTTLED:
+            return THROTTLED_DOWNLOAD_FAILURE_STR;
+        case EDownloadFailure::HARD:
+            return HARD_DOWNLOAD_FAILURE_STR;
+        case EDownloadFailure::TRUNCATED:
+            return TRUNCATED_DOWNLOAD_FAILURE_STR;
+    }
+    return NONE_DOWNLOAD_FAILURE_STR;
+}
+
+CDownloadTimeouts::CDownloadTimeouts()
+    : _connect(10000)
+    , _handshake(10000)
+    , _firstByte(20000)
+    , _total(60000)
+{
+}
+
+CDownloadResult::CDownloadResult(int statusCode, std::string_view errorMessage, bool isTruncated)
+    : _statusCode(statusCode)
+    , _errorMessage(errorMessage)
+    , _isTruncated(isTruncated)
+{
+}
+
+EDownloadFailure CDownloadResult::getFailure() const
+{
+    if (isSuccess())
+    {
+        return EDownloadFailure::NONE;
+    }
+    if (_isTruncated)
+    {
+        return EDownloadFailure::TRUNCATED;
+    }
+    if ((_statusCode == 429) || (_statusCode == 503))
+    {
+        return EDownloadFailure::THROTTLED;
+    }
+    // server errors and request timeout are worth repeating, other statuses won't change
+    bool isServerError = (_statusCode / 100 == 5) || (_statusCode == 408);
+    if ((_statusCode != 0) && !isServerError)
+    {
+        return EDownloadFailure::HARD;
+    }
+    return EDownloadFailure::TRANSIENT;
+}
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <chrono>
+#include <functional>
+#include "cancellation_token.h"
+#include "response_cutoff.h"
+
+namespace watchList
+{
+    enum class EDownloadBackend
+    {
+        AUTO = 0,
+        HTTPS,
+        WEB_KIT
+    };
+
+    enum class EDownloadFailure
+    {
+        NONE = 0,
+        // connection errors and server errors which are likely to go away
+        TRANSIENT,
+        // server asks to slow down
+        THROTTLED,
+        // client errors, request won't succeed if it is repeated
+        HARD,
+        // connection is closed before the whole page is received
+        TRUNCATED
+    };
+
+    std::string_view getDownloadFailure(EDownloadFailure failure);
+
+    class CDownloadTimeouts
+    {
+        friend class CCmdLineParamsParser;
+
+    public:
+        typedef std::chrono::milliseconds Duration;
+
+    public:
+        CDownloadTimeouts();
+
+    public:
+        // resolve and TCP connect
+        Duration getConnect() const
+            { return _connect; }
+
+        Duration getHandshake() const
+            { return _handshake; }
+
+        // from sending request to receiving response header
+        Duration getFirstByte() const
+            { return _firstByte; }
+
+        // whole download attempt
+        Duration getTotal() const
+            { return _total; }
+
+    private:
+        Duration _connect;
+        Duration _handshake;
+        Duration _firstByte;
+        Duration _total;
+    };
+
+    class CDownloadResult
+    {
+    public:
+        CDownloadResult(int statusCode = 0, std::string_view errorMessage = std::string_view(), bool isTruncated = false);
+
+    public:
+        // zero if server hasn't responded
+        int getStatusCode() const
+            { return _statusCode; }
+
+        // empty if the link was successfully downloaded
+        const std::string& getErrorMessage() const
+            { return _errorMessage; }
+
+        bool isSuccess() const
+            { return _errorMessage.empty(); }
+
+        EDownloadFailure getFailure() const;
+
+        const std::string& getContent() const
+            { return _content; }
+
+        std::string& getContent()
+            { return _content; }
+
+    private:
+        int _statusCode;
+        std::string _errorMessage;
+        std::string _content;
+        bool _isTruncated;
+    };
+
+    class CDownloadBackend
+    {
+    public:
+        typedef std::function<void(CDownloadResult&& result)> CompletionHandler;
+
+    public:
+        virtual ~CDownloadBackend() = default;
+
+    public:
+        virtual bool isSupported(std::string_view link) const = 0;
+
+        // Content of the page is passed to handler, it is also saved to destination file if destination isn't empty.
+        // Content is cut at the end of the part which cutoff needs, backend may stop downloading there.
+        // Handler can be called from any thread, it is called once even if download is cancelled.
+        virtual void download(const std::string& link, const std::string& destination, const CResponseCutoff& cutoff,
+            CompletionHandler handler, const CCancellationToken& cancellationToken) = 0;
+
+        // Opens connections to host of the link before downloads start, backend may ignore it.
+        virtual void preconnect(const std::string& /*link*/, int /*numConnections*/)
+            {}
+    };
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <boost/date_time.hpp>
+#include "download_scheduler.h"
+
+namespace watchList
+{
+CDownloadScheduler::HostState::HostState(const CHostRateLimit& rateLimit)
+    : tokenBucket(rateLimit.getRequestsPerSecond(), rateLimit.getBurst())
+    , rateController(rateLimit)
+    , numTasksInProcess(0)
+{
+}
+
+void CDownloadScheduler::setSettings(const CDownloaderSettings& settings)
+{
+    _settings = settings;
+    for (auto& [host, hostState] : _hostStates)
+    {
+        const CHostRateLimit& rateLimit = _settings.getHostRateLimit(host);
+        hostState.tokenBucket = CTokenBucket(rateLimit.getRequestsPerSecond(), rateLimit.getBurst());
+        hostState.rateController = CAdaptiveRateController(rateLimit);
+    }
+
+    _throttleLog.close();
+    if (!_settings.getThrottleLogFilePath().empty())
+    {
+        _throttleLog.open(_settings.getThrottleLogFilePath(), std::ios::app);
+    }
+}
+
+CDownloadScheduler::HostState& CDownloadScheduler::getHostState(const std::string& host)
+{
+    auto it = _hostStates.find(host);
+    if (it == _hostStates.end())
+    {
+        it = _hostStates.emplace(host, HostState(_settings.getHostRateLimit(host))).first;
+    }
+    return it->second;
+}
+
+bool CDownloadScheduler::isHostBusy(const std::string& host) const
+{
+    auto it = _hostStates.find(host);
+    return (it != _hostStates.end()) && (it->second.numTasksInProcess >= _settings.getMaxTasksPerHost());
+}
+
+CDownloadScheduler::Clock::duration CDownloadScheduler::getWaitTime(const std::string& host, Clock::time_point now)
+{
+    return getHostState(host).tokenBucket.getWaitTime(now);
+}
+
+bool CDownloadScheduler::tryStartTask(const std::string& host, Clock::time_point now)
+{
+    if (isHostBusy(host))
+    {
+        return false;
+    }
+    HostState& hostState = getHostState(host);
+    if (!hostState.tokenBucket.tryConsume(now))
+    {
+        return false;
+    }
+    ++hostState.numTasksInProcess;
+    return true;
+}
+
+void CDownloadScheduler::completeTask(const std::string& host, const CDownloadResult& result, Clock::time_point startTime, Clock::time_point now)
+{
+    HostState& hostState = getHostState(host);
+    if (hostState.numTasksInProcess > 0)
+    {
+        --hostState.numTasksInProcess;
+    }
+
+    if (_settings.isAdaptiveRate() && hostState.rateController.isAdaptive())
+    {
+        EThrottleDecision decision = hostState.rateController.update(result, startTime, now);
+        hostState.tokenBucket.setRate(hostState.rateController.getRate(), now);
+        logDecision(host, decision, hostState.rateController);
+    }
+}
+
+void CDownloadScheduler::cancelTask(const std::string& host)
+{
+    HostState& hostState = getHostState(host);
+    if (hostState.numTasksInProcess > 0)
+    {
+        --hostState.numTasksInProcess;
+    }
+}
+
+void CDownloadScheduler::logDecision(const std::string& host, EThrottleDecision decision, const CAdaptiveRateController& rateController)
+{
+    if (decision == EThrottleDecision::DECREASE)
+    {
+        std::cerr << "Slow down " << host << " to " << rateController.getRate() << " requests per second : " << rateController.getReason() << std::endl;
+    }
+    if (_throttleLog.is_open())
+    {
+        _throttleLog << boost::posix_time::second_clock::local_time() << " " << host << " " << getThrottleDecision(decision)
+            << " " << rateController.getRate() << " " << rateController.getReason() << std::endl;
+    }
+}
+}
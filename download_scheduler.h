@@ -0,0 +1,51 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <fstream>
+#include "token_bucket.h"
+#include "adaptive_rate_controller.h"
+#include "downloader_settings.h"
+
+namespace watchList
+{
+    // Keeps politeness budget of every host separately, so tasks of different hosts don't wait for each other
+    class CDownloadScheduler
+    {
+    public:
+        typedef CTokenBucket::Clock Clock;
+
+    public:
+        void setSettings(const CDownloaderSettings& settings);
+
+    public:
+        bool isHostBusy(const std::string& host) const;
+        Clock::duration getWaitTime(const std::string& host, Clock::time_point now);
+
+        bool tryStartTask(const std::string& host, Clock::time_point now);
+        void completeTask(const std::string& host, const CDownloadResult& result, Clock::time_point startTime, Clock::time_point now);
+        // cancelled task says nothing about host load, it only gives its place to others
+        void cancelTask(const std::string& host);
+
+    private:
+        struct HostState
+        {
+            HostState(const CHostRateLimit& rateLimit);
+
+            CTokenBucket tokenBucket;
+            CAdaptiveRateController rateController;
+            int numTasksInProcess;
+        };
+
+        typedef std::map<std::string, HostState> HostStates;
+
+    private:
+        HostState& getHostState(const std::string& host);
+        void logDecision(const std::string& host, EThrottleDecision decision, const CAdaptiveRateController& rateController);
+
+    private:
+        CDownloaderSettings _settings;
+        HostStates _hostStates;
+        std::ofstream _throttleLog;
+    };
+}
@@ -0,0 +1,142 @@
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include "downloader_settings.h"
+
+namespace watchList
+{
+std::string_view CHostRateLimit::PARAM_NAME_RATE = "-rate:";
+std::string_view CHostRateLimit::PARAM_NAME_BURST = "-burst:";
+std::string_view CHostRateLimit::PARAM_NAME_MIN_RATE = "-minRate:";
+std::string_view CHostRateLimit::PARAM_NAME_MAX_RATE = "-maxRate:";
+std::string_view CHostRateLimit::PARAM_NAME_RATE_STEP = "-rateStep:";
+std::string_view CHostRateLimit::PARAM_NAME_MAX_LATENCY = "-maxLatency:";
+
+CHostRateLimit::CHostRateLimit()
+    : _requestsPerSecond(2.0)
+    , _burst(1.0)
+    , _minRequestsPerSecond(0.2)
+    , _maxRequestsPerSecond(5.0)
+    , _rateStep(0.05)
+    , _maxLatencyMs(3000)
+{
+}
+
+void CHostRateLimit::parse(std::string_view line, std::string_view paramName, double& value)
+{
+    std::size_t paramPos = line.find(paramName);
+    if (paramPos != std::string::npos)
+    {
+        auto first = line.begin() + paramPos + paramName.size();
+        auto last = std::find_if(first, line.end(), ::isspace);
+        value = std::stod(std::string(first, last));
+    }
+}
+
+void CHostRateLimit::parse(std::string_view line)
+{
+    parse(line, PARAM_NAME_RATE, _requestsPerSecond);
+    parse(line, PARAM_NAME_BURST, _burst);
+    parse(line, PARAM_NAME_MIN_RATE, _minRequestsPerSecond);
+    parse(line, PARAM_NAME_MAX_RATE, _maxRequestsPerSecond);
+    parse(line, PARAM_NAME_RATE_STEP, _rateStep);
+
+    double maxLatencyMs = _maxLatencyMs;
+    parse(line, PARAM_NAME_MAX_LATENCY, maxLatencyMs);
+    _maxLatencyMs = static_cast<int>(maxLatencyMs);
+}
+
+CDownloaderSettings::CDownloaderSettings()
+    : _backend(EDownloadBackend::AUTO)
+    , _numWorkers(4)
+    , _maxTasksPerHost(4)
+    , _isAdaptiveRate(true)
+    , _isPreconnect(false)
+    , _maxAttempts(4)
+    , _retryDelayMs(1000)
+    , _maxRetryDelayMs(60000)
+    , _isKeepDownloads(false)
+    , _maxPageSizeKb(0)
+{
+}
+
+const CHostRateLimit& CDownloaderSettings::getHostRateLimit(std::string_view host) const
+{
+    // limit of the domain applies to all its subdomains
+    while (!host.empty())
+    {
+        auto it = _hostRateLimits.find(host);
+        if (it != _hostRateLimits.end())
+        {
+            return it->second;
+        }
+        std::size_t dotPos = host.find('.');
+        host = (dotPos == std::string::npos) ? std::string_view() : host.substr(dotPos + 1);
+    }
+    return _defaultHostRateLimit;
+}
+
+bool CDownloaderSettings::isHttp2Host(std::string_view host) const
+{
+    while (!host.empty())
+    {
+        if (_http2Hosts.count(host) != 0)
+        {
+            return true;
+        }
+        std::size_t dotPos = host.find('.');
+        host = (dotPos == std::string::npos) ? std::string_view() : host.substr(dotPos + 1);
+    }
+    return false;
+}
+
+void CDownloaderSettings::loadHostRateLimits(const std::string& hostsFilePath)
+{
+    std::ifstream hostsFile;
+    hostsFile.exceptions(std::ios::badbit);
+    hostsFile.open(hostsFilePath);
+
+    // default limit is parsed first, so hosts inherit its values wherever it is listed
+    std::vector<std::pair<int, std::string>> hostLines;
+    std::string line;
+    for (int lineNum = 1; std::getline(hostsFile, line); ++lineNum)
+    {
+        std::string_view host = std::string_view(line).substr(0, line.find_first_of(" \t"));
+        if (host == "*")
+        {
+            parseHostRateLimit(hostsFilePath, lineNum, line, _defaultHostRateLimit);
+        }
+        else if (!host.empty())
+        {
+            hostLines.emplace_back(lineNum, std::move(line));
+        }
+    }
+    for (const auto& [lineNum, hostLine] : hostLines)
+    {
+        CHostRateLimit hostRateLimit = _defaultHostRateLimit;
+        if (parseHostRateLimit(hostsFilePath, lineNum, hostLine, hostRateLimit))
+        {
+            _hostRateLimits.insert_or_assign(hostLine.substr(0, hostLine.find_first_of(" \t")), hostRateLimit);
+        }
+    }
+}
+
+bool CDownloaderSettings::parseHostRateLimit(const std::string& hostsFilePath, int lineNum, std::string_view line, CHostRateLimit& hostRateLimit)
+{
+    // line with malformed value is skipped, the host keeps default limit
+    CHostRateLimit parsedHostRateLimit = hostRateLimit;
+    try
+    {
+        parsedHostRateLimit.parse(line);
+    }
+    catch (const std::logic_error&)
+    {
+        std::cerr << "Can't parse " << hostsFilePath << ":" << lineNum << ": " << line << std::endl;
+        return false;
+    }
+    hostRateLimit = parsedHostRateLimit;
+    return true;
+}
+}
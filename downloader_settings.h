@@ -0,0 +1,150 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include "download_backend.h"
+
+namespace watchList
+{
+    class CHostRateLimit
+    {
+    public:
+        CHostRateLimit();
+
+    public:
+        double getRequestsPerSecond() const
+            { return _requestsPerSecond; }
+
+        double getBurst() const
+            { return _burst; }
+
+        double getMinRequestsPerSecond() const
+            { return _minRequestsPerSecond; }
+
+        double getMaxRequestsPerSecond() const
+            { return _maxRequestsPerSecond; }
+
+        double getRateStep() const
+            { return _rateStep; }
+
+        int getMaxLatencyMs() const
+            { return _maxLatencyMs; }
+
+    public:
+        void parse(std::string_view line);
+
+    private:
+        static std::string_view PARAM_NAME_RATE;
+        static std::string_view PARAM_NAME_BURST;
+        static std::string_view PARAM_NAME_MIN_RATE;
+        static std::string_view PARAM_NAME_MAX_RATE;
+        static std::string_view PARAM_NAME_RATE_STEP;
+        static std::string_view PARAM_NAME_MAX_LATENCY;
+
+    private:
+        static void parse(std::string_view line, std::string_view paramName, double& value);
+
+    private:
+        double _requestsPerSecond;
+        double _burst;
+        double _minRequestsPerSecond;
+        double _maxRequestsPerSecond;
+        double _rateStep;
+        int _maxLatencyMs;
+    };
+
+    class CDownloaderSettings
+    {
+        friend class CCmdLineParamsParser;
+
+    public:
+        CDownloaderSettings();
+
+    public:
+        EDownloadBackend getBackend() const
+            { return _backend; }
+
+        int getNumWorkers() const
+            { return _numWorkers; }
+
+        int getMaxTasksPerHost() const
+            { return _maxTasksPerHost; }
+
+        bool isAdaptiveRate() const
+            { return _isAdaptiveRate; }
+
+        // connections to host are opened as soon as its first task is added
+        bool isPreconnect() const
+            { return _isPreconnect; }
+
+        // including the first attempt
+        int getMaxAttempts() const
+            { return _maxAttempts; }
+
+        // delay before the first retry, it doubles with every next one
+        int getRetryDelayMs() const
+            { return _retryDelayMs; }
+
+        int getMaxRetryDelayMs() const
+            { return _maxRetryDelayMs; }
+
+        // downloads are saved to files to continue interrupted session
+        bool isKeepDownloads() const
+            { return _isKeepDownloads; }
+
+        const std::string& getThrottleLogFilePath() const
+            { return _throttleLogFilePath; }
+
+        const CDownloadTimeouts& getTimeouts() const
+            { return _timeouts; }
+
+        // pages are cut at this size, zero means no limit
+        int getMaxPageSizeKb() const
+            { return _maxPageSizeKb; }
+
+        // "<host>:<port>" of replay server which gets all HTTPS connections instead of real hosts
+        const std::string& getReplayAddress() const
+            { return _replayAddress; }
+
+        // successful downloads are added to replay corpus in this directory
+        const std::string& getRecordDirPath() const
+            { return _recordDirPath; }
+
+        const CHostRateLimit& getHostRateLimit(std::string_view host) const;
+
+        // requests to host and its subdomains are multiplexed over one HTTP/2 connection
+        bool isHttp2Host(std::string_view host) const;
+
+    public:
+        // every line of file is "<host> -rate:<requests per second> -burst:<requests>", host "*" sets default limit.
+        // Optional -minRate:, -maxRate:, -rateStep: and -maxLatency:<ms> tune adaptive rate of the host.
+        void loadHostRateLimits(const std::string& hostsFilePath);
+
+    private:
+        typedef std::map<std::string, CHostRateLimit, std::less<>> HostRateLimits;
+        typedef std::set<std::string, std::less<>> Hosts;
+
+    private:
+        static bool parseHostRateLimit(const std::string& hostsFilePath, int lineNum, std::string_view line, CHostRateLimit& hostRateLimit);
+
+    private:
+        EDownloadBackend _backend;
+        int _numWorkers;
+        int _maxTasksPerHost;
+        bool _isAdaptiveRate;
+        bool _isPreconnect;
+        int _maxAttempts;
+        int _retryDelayMs;
+        int _maxRetryDelayMs;
+        bool _isKeepDownloads;
+        std::string _throttleLogFilePath;
+        CDownloadTimeouts _timeouts;
+        int _maxPageSizeKb;
+        std::string _replayAddress;
+        std::string _recordDirPath;
+        CHostRateLimit _defaultHostRateLimit;
+        HostRateLimits _hostRateLimits;
+        Hosts _http2Hosts;
+    };
+}
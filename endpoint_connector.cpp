@@ -0,0 +1,146 @@
+#include <boost/asio/error.hpp>
+#include <algorithm>
+#include "endpoint_connector.h"
+
+using namespace boost::asio;
+using namespace boost::system;
+
+namespace watchList
+{
+// delay recommended by RFC 8305
+std::chrono::milliseconds CEndpointConnector::ATTEMPT_DELAY(250);
+
+CEndpointConnector::CEndpointConnector(io_context& ioContext, const ResolveResults& resolveResults, ConnectHandler handler)
+    : _ioContext(ioContext)
+    , _endpoints(interleaveFamilies(resolveResults))
+    , _attemptTimer(ioContext)
+    , _timeoutTimer(ioContext)
+    , _numAttemptsInProcess(0)
+    , _isCompleted(false)
+    , _lastErrorCode(error::host_not_found)
+    , _handler(std::move(handler))
+{
+}
+
+CEndpointConnector::EndpointList CEndpointConnector::interleaveFamilies(const ResolveResults& resolveResults)
+{
+    // resolver usually returns all addresses of preferred family first, one broken family would stall every attempt
+    EndpointList firstFamily;
+    EndpointList secondFamily;
+    for (const auto& result : resolveResults)
+    {
+        bool isFirstFamily = firstFamily.empty() || (result.endpoint().protocol() == firstFamily.front().protocol());
+        (isFirstFamily ? firstFamily : secondFamily).push_back(result.endpoint());
+    }
+
+    EndpointList endpoints;
+    for (std::size_t i = 0; i < std::max(firstFamily.size(), secondFamily.size()); ++i)
+    {
+        if (i < firstFamily.size())
+        {
+            endpoints.push_back(firstFamily[i]);
+        }
+        if (i < secondFamily.size())
+        {
+            endpoints.push_back(secondFamily[i]);
+        }
+    }
+    return endpoints;
+}
+
+void CEndpointConnector::startTimeout(std::chrono::steady_clock::duration timeout)
+{
+    _timeoutTimer.expires_after(timeout);
+    _timeoutTimer.async_wait(
+        [ptrThis = shared_from_this()](const error_code& errorCode)
+        {
+            if (!errorCode && !ptrThis->_isCompleted)
+            {
+                ptrThis->complete(error::timed_out, ip::tcp::socket(ptrThis->_ioContext));
+            }
+        });
+}
+
+void CEndpointConnector::startAttempt()
+{
+    if (_sockets.size() == _endpoints.size())
+    {
+        if (_numAttemptsInProcess == 0)
+        {
+            complete(_lastErrorCode, ip::tcp::socket(_ioContext));
+        }
+        return;
+    }
+
+    std::size_t attemptIndex = _sockets.size();
+    _sockets.push_back(std::make_unique<ip::tcp::socket>(_ioContext));
+    ++_numAttemptsInProcess;
+    _sockets.back()->async_connect(_endpoints[attemptIndex],
+        [ptrThis = shared_from_this(), attemptIndex](const error_code& errorCode)
+        {
+            ptrThis->onAttemptCompleted(attemptIndex, errorCode);
+        });
+
+    _attemptTimer.expires_after(ATTEMPT_DELAY);
+    _attemptTimer.async_wait(
+        [ptrThis = shared_from_this()](const error_code& errorCode)
+        {
+            if (!errorCode && !ptrThis->_isCompleted)
+            {
+                ptrThis->startAttempt();
+            }
+        });
+}
+
+void CEndpointConnector::onAttemptCompleted(std::size_t attemptIndex, const error_code& errorCode)
+{
+    --_numAttemptsInProcess;
+    if (_isCompleted)
+    {
+        return;
+    }
+
+    if (!errorCode)
+    {
+        // socket is taken out before the rest are closed
+        ip::tcp::socket socket(std::move(*_sockets[attemptIndex]));
+        complete(errorCode, std::move(socket));
+    }
+    else
+    {
+        // failed address doesn't wait for the delay, the next one is tried at once
+        _lastErrorCode = errorCode;
+        startAttempt();
+    }
+}
+
+void CEndpointConnector::complete(const error_code& errorCode, ip::tcp::socket&& socket)
+{
+    _isCompleted = true;
+    _attemptTimer.cancel();
+    _timeoutTimer.cancel();
+    for (auto& ptrSocket : _sockets)
+    {
+        error_code closeErrorCode;
+        ptrSocket->close(closeErrorCode);
+    }
+    _handler(errorCode, std::move(socket));
+}
+
+void CEndpointConnector::cancel()
+{
+    if (!_isCompleted)
+    {
+        complete(error::operation_aborted, ip::tcp::socket(_ioContext));
+    }
+}
+
+CEndpointConnector::SharedPtr CEndpointConnector::asyncConnect(io_context& ioContext, const ResolveResults& resolveResults,
+    std::chrono::steady_clock::duration timeout, ConnectHandler handler)
+{
+    auto ptrConnector = std::make_shared<CEndpointConnector>(ioContext, resolveResults, std::move(handler));
+    ptrConnector->startTimeout(timeout);
+    ptrConnector->startAttempt();
+    return ptrConnector;
+}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <functional>
+
+namespace watchList
+{
+    // Connects to the first answering address of the host. Next address is tried when the previous one doesn't
+    // answer in a short delay or fails, attempts run in parallel and address families alternate (happy eyeballs).
+    class CEndpointConnector : public std::enable_shared_from_this<CEndpointConnector>
+    {
+    public:
+        typedef boost::asio::ip::tcp::resolver::results_type ResolveResults;
+        typedef std::function<void(const boost::system::error_code& errorCode, boost::asio::ip::tcp::socket&& socket)> ConnectHandler;
+        typedef std::shared_ptr<CEndpointConnector> SharedPtr;
+
+    public:
+        CEndpointConnector(boost::asio::io_context& ioContext, const ResolveResults& resolveResults, ConnectHandler handler);
+
+        // all attempts fail with timed_out error when none of them succeeds in timeout
+        static SharedPtr asyncConnect(boost::asio::io_context& ioContext, const ResolveResults& resolveResults,
+            std::chrono::steady_clock::duration timeout, ConnectHandler handler);
+
+        // all attempts are closed and handler gets operation_aborted error, unless connector has completed already
+        void cancel();
+
+    private:
+        typedef std::vector<boost::asio::ip::tcp::endpoint> EndpointList;
+        typedef std::vector<std::unique_ptr<boost::asio::ip::tcp::socket>> SocketList;
+
+    private:
+        static std::chrono::milliseconds ATTEMPT_DELAY;
+
+    private:
+        static EndpointList interleaveFamilies(const ResolveResults& resolveResults);
+
+        void startTimeout(std::chrono::steady_clock::duration timeout);
+        void startAttempt();
+        void onAttemptCompleted(std::size_t attemptIndex, const boost::system::error_code& errorCode);
+        void complete(const boost::system::error_code& errorCode, boost::asio::ip::tcp::socket&& socket);
+
+    private:
+        boost::asio::io_context& _ioContext;
+        EndpointList _endpoints;
+        SocketList _sockets;
+        boost::asio::steady_timer _attemptTimer;
+        boost::asio::steady_timer _timeoutTimer;
+        int _numAttemptsInProcess;
+        bool _isCompleted;
+        boost::system::error_code _lastErrorCode;
+        ConnectHandler _handler;
+    };
+}
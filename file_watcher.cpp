@@ -0,0 +1,109 @@
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <filesystem>
+#include "file_watcher.h"
+
+namespace watchList
+{
+CFileWatcher::CFileWatcher()
+    : _inotifyFd(inotify_init1(IN_CLOEXEC))
+    , _stopFd(eventfd(0, EFD_CLOEXEC))
+{
+    if ((_inotifyFd < 0) || (_stopFd < 0))
+    {
+        std::string message = std::string("Can't start file watcher: ") + std::strerror(errno);
+        if (_inotifyFd >= 0)
+        {
+            close(_inotifyFd);
+        }
+        if (_stopFd >= 0)
+        {
+            close(_stopFd);
+        }
+        throw std::runtime_error(message);
+    }
+    _thread = std::thread([this]() { run(); });
+}
+
+CFileWatcher::~CFileWatcher()
+{
+    std::uint64_t value = 1;
+    write(_stopFd, &value, sizeof(value));
+    _thread.join();
+    close(_inotifyFd);
+    close(_stopFd);
+}
+
+void CFileWatcher::watch(const std::string& filePath, ChangeHandler handler)
+{
+    std::filesystem::path path = std::filesystem::absolute(filePath);
+    std::string dirPath = path.parent_path().string();
+    // editors either rewrite the file or move a new one in its place
+    int watchDescriptor = inotify_add_watch(_inotifyFd, dirPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watchDescriptor < 0)
+    {
+        throw std::runtime_error("Can't watch " + dirPath + " : " + std::strerror(errno));
+    }
+
+    std::unique_lock lock(_mutex);
+    _handlers[watchDescriptor][path.filename().string()] = std::move(handler);
+}
+
+void CFileWatcher::onEvent(int watchDescriptor, std::string_view fileName)
+{
+    ChangeHandler handler;
+    {
+        std::unique_lock lock(_mutex);
+        auto dirIt = _handlers.find(watchDescriptor);
+        if (dirIt == _handlers.end())
+        {
+            return;
+        }
+        auto fileIt = dirIt->second.find(fileName);
+        if (fileIt == dirIt->second.end())
+        {
+            return;
+        }
+        handler = fileIt->second;
+    }
+    // handler may take long, so new files can be watched meanwhile
+    handler();
+}
+
+void CFileWatcher::run()
+{
+    alignas(inotify_event) char buffer[4096];
+    pollfd pollFds[] = { { _inotifyFd, POLLIN, 0 }, { _stopFd, POLLIN, 0 } };
+    while (true)
+    {
+        if (poll(pollFds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        if (pollFds[1].revents != 0)
+        {
+            return;
+        }
+
+        ssize_t numBytes = read(_inotifyFd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < numBytes; )
+        {
+            const inotify_event* ptrEvent = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (ptrEvent->len > 0)
+            {
+                onEvent(ptrEvent->wd, ptrEvent->name);
+            }
+            offset += sizeof(inotify_event) + ptrEvent->len;
+        }
+    }
+}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <functional>
+
+namespace watchList
+{
+    // Reports changes of files through inotify on its own thread.
+    // Directory of the file is watched, so files replaced by editors through rename are reported as well.
+    class CFileWatcher
+    {
+    public:
+        // called from watcher thread
+        typedef std::function<void()> ChangeHandler;
+
+    public:
+        CFileWatcher();
+        ~CFileWatcher();
+
+        CFileWatcher(const CFileWatcher&) = delete;
+        CFileWatcher& operator=(const CFileWatcher&) = delete;
+
+    public:
+        // throws runtime_error if directory of the file can't be watched
+        void watch(const std::string& filePath, ChangeHandler handler);
+
+    private:
+        typedef std::map<std::string, ChangeHandler, std::less<>> FileHandlers;
+        // files are grouped by watch descriptor of their directory
+        typedef std::map<int, FileHandlers> DirectoryHandlers;
+
+    private:
+        void run();
+        void onEvent(int watchDescriptor, std::string_view fileName);
+
+    private:
+        int _inotifyFd;
+        // written by destructor to stop the thread
+        int _stopFd;
+        std::mutex _mutex;
+        DirectoryHandlers _handlers;
+        std::thread _thread;
+    };
+}
@@ -1,8 +1,5 @@
-#include <boost/beast/core/buffers_to_string.hpp>
 #include "html_parser.h"
 
-using namespace boost;
-
 namespace watchList
 {
 CHtmlParser::CHtmlParser()
@@ -70,7 +67,7 @@ std::string_view CHtmlParser::getAttributeValue(std::string_view name) const
 }    
     
 CHtmlContent::CHtmlContent(const CAsyncHttpsDownloader::ResponseType& response)
-    : _htmlContent(buffers_to_string(response.body().data()))
+    : _htmlContent(response.body())
 {
 }
 
@@ -79,6 +76,11 @@ CHtmlContent::CHtmlContent(const std::stringstream& response)
 {
 }
 
+CHtmlContent::CHtmlContent(std::string&& response)
+    : _htmlContent(std::move(response))
+{
+}
+
 CHtmlParser CHtmlContent::createParser() const
 {
     return CHtmlParser(_htmlContent);
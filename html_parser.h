@@ -1,6 +1,7 @@
 #pragma once
 
 #include "async_https_downloader.h"
+#include "response_cutoff.h"
 #include <string>
 #include <vector>
 #include <sstream>
@@ -31,6 +32,7 @@ namespace watchList
     public:
         CHtmlContent(const CAsyncHttpsDownloader::ResponseType& response);
         CHtmlContent(const std::stringstream& response);
+        CHtmlContent(std::string&& response);
         
     public:
         CHtmlParser createParser() const;
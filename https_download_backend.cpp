@@ -0,0 +1,171 @@
+// boost 1.74 awaitable.hpp uses std::exchange without including it
+#include <utility>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/ssl/error.hpp>
+#include <boost/beast/http/error.hpp>
+#include <fstream>
+#include <optional>
+#include <iostream>
+#include "https_download_backend.h"
+
+using namespace boost::asio;
+using namespace boost::beast;
+using namespace boost::system;
+
+namespace watchList
+{
+CHttpsDownloadBackend::CHttpsDownloadBackend(const CDownloaderSettings& settings)
+    : _settings(settings)
+    , _workGuard(make_work_guard(_ioContext))
+    , _dnsCache(_ioContext)
+{
+    if (!_settings.getRecordDirPath().empty())
+    {
+        _ptrRecordCorpus = std::make_unique<CReplayCorpus>(_settings.getRecordDirPath());
+        // recording goes on from the previous session, its pages aren't recorded twice
+        if (_ptrRecordCorpus->hasIndex())
+        {
+            _ptrRecordCorpus->load();
+        }
+    }
+    _thread = std::thread([this]() { _ioContext.run(); });
+}
+
+CHttpsDownloadBackend::~CHttpsDownloadBackend()
+{
+    _workGuard.reset();
+    _ioContext.stop();
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+bool CHttpsDownloadBackend::isSupported(std::string_view link) const
+{
+    return CUrlParser(link).isSecure();
+}
+
+CAsyncHostDownloader& CHttpsDownloadBackend::getDownloader(const CUrlParser& url)
+{
+    std::string hostKey = url.getHost() + ":" + url.getPort();
+    auto it = _downloaders.find(hostKey);
+    if (it == _downloaders.end())
+    {
+        CAsyncHostDownloader::UniquePtr ptrDownloader;
+        // replay server chooses HTTP/2 by ALPN too, so replay benchmarks the same protocol
+        if (_settings.isHttp2Host(url.getHost()))
+        {
+            ptrDownloader = std::make_unique<CAsyncHttp2Downloader>(_ioContext, _dnsCache, url.getHost(), url.getPort(), _settings.getTimeouts());
+        }
+        else
+        {
+            ptrDownloader = std::make_unique<CAsyncHttpsDownloader>(_ioContext, _dnsCache, url.getHost(), url.getPort(), _settings.getTimeouts());
+        }
+        if (!_settings.getReplayAddress().empty())
+        {
+            CUrlParser replayUrl("https://" + _settings.getReplayAddress());
+            ptrDownloader->setConnectAddress(replayUrl.getHost(), replayUrl.getPort());
+        }
+        it = _downloaders.emplace(hostKey, std::move(ptrDownloader)).first;
+    }
+    return *it->second;
+}
+
+void CHttpsDownloadBackend::saveResponse(const CAsyncHostDownloader::ResponseType& response, const std::string& destination)
+{
+    std::ofstream responseFile;
+    responseFile.exceptions(std::ios::failbit | std::ios::badbit);
+    responseFile.open(destination, std::ios::binary);
+    responseFile.write(response.body().data(), response.body().size());
+}
+
+void CHttpsDownloadBackend::recordResponse(const CUrlParser& url, const CAsyncHostDownloader::ResponseType& response)
+{
+    try
+    {
+        _ptrRecordCorpus->addPage(url.getHost(), url.getTarget(), response.body());
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Error recording " << url.getHost() << url.getTarget() << " : " << ex.what() << std::endl;
+    }
+}
+
+void CHttpsDownloadBackend::download(const std::string& link, const std::string& destination, const CResponseCutoff& cutoff,
+    CompletionHandler handler, const CCancellationToken& cancellationToken)
+{
+    // downloaders are touched only from io context thread, coroutine starts there
+    co_spawn(_ioContext, downloadPage(link, destination, cutoff, std::move(handler), cancellationToken), detached);
+}
+
+awaitable<void> CHttpsDownloadBackend::downloadPage(std::string link, std::string destination, CResponseCutoff cutoff, CompletionHandler handler,
+    CCancellationToken cancellationToken)
+{
+    std::optional<CUrlParser> url;
+    CAsyncHostDownloader::ResponseType response;
+    error_code errorCode;
+    try
+    {
+        url.emplace(link);
+        response = co_await getDownloader(*url).fetch(url->getTarget(), redirect_error(use_awaitable, errorCode), cancellationToken, cutoff);
+    }
+    catch (const std::exception& ex)
+    {
+        handler(CDownloadResult(0, "Error downloading " + link + " : " + ex.what()));
+        co_return;
+    }
+
+    if (errorCode)
+    {
+        // server has closed connection in the middle of the body
+        bool isTruncated = (errorCode == http::error::partial_message) || (errorCode == ssl::error::stream_truncated);
+        handler(CDownloadResult(0, "Error downloading " + link + " : " + errorCode.message(), isTruncated));
+        co_return;
+    }
+    if (response.result_int() / 100 != 2)
+    {
+        handler(CDownloadResult(response.result_int(), "Error downloading " + link + " : HTTP status " + std::to_string(response.result_int())));
+        co_return;
+    }
+
+    if (_ptrRecordCorpus)
+    {
+        // page is recorded as far as cutoff has read it, which is enough for its parser
+        recordResponse(*url, response);
+    }
+    try
+    {
+        if (!destination.empty())
+        {
+            saveResponse(response, destination);
+        }
+        CDownloadResult result(response.result_int());
+        result.getContent() = std::move(response.body());
+        handler(std::move(result));
+    }
+    catch (const std::exception& ex)
+    {
+        handler(CDownloadResult(response.result_int(), "Error saving " + link + " : " + ex.what()));
+    }
+}
+
+void CHttpsDownloadBackend::preconnect(const std::string& link, int numConnections)
+{
+    post(_ioContext,
+        [this, link, numConnections]()
+        {
+            try
+            {
+                getDownloader(CUrlParser(link)).preconnect(numConnections);
+            }
+            catch (const std::exception&)
+            {
+                // download of the link reports the same error later
+            }
+        });
+}
+}
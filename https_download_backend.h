@@ -0,0 +1,57 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <map>
+#include <memory>
+#include <thread>
+#include "async_https_downloader.h"
+#include "async_http2_downloader.h"
+#include "dns_cache.h"
+#include "download_backend.h"
+#include "downloader_settings.h"
+#include "replay_corpus.h"
+#include "url_parser.h"
+
+namespace watchList
+{
+    // Fetches pages with plain HTTPS requests, doesn't need display or web engine
+    class CHttpsDownloadBackend : public CDownloadBackend
+    {
+    public:
+        CHttpsDownloadBackend(const CDownloaderSettings& settings = CDownloaderSettings());
+        ~CHttpsDownloadBackend();
+
+    public:
+        bool isSupported(std::string_view link) const override;
+        void download(const std::string& link, const std::string& destination, const CResponseCutoff& cutoff,
+            CompletionHandler handler, const CCancellationToken& cancellationToken) override;
+        void preconnect(const std::string& link, int numConnections) override;
+
+    private:
+        // runs on io context thread, handler is called once whatever happens
+        boost::asio::awaitable<void> downloadPage(std::string link, std::string destination, CResponseCutoff cutoff, CompletionHandler handler,
+            CCancellationToken cancellationToken);
+        // hosts chosen in settings get HTTP/2 downloader, the rest use HTTP/1.1
+        CAsyncHostDownloader& getDownloader(const CUrlParser& url);
+        // failed recording doesn't fail the download
+        void recordResponse(const CUrlParser& url, const CAsyncHostDownloader::ResponseType& response);
+
+        static void saveResponse(const CAsyncHostDownloader::ResponseType& response, const std::string& destination);
+
+    private:
+        typedef std::map<std::string, CAsyncHostDownloader::UniquePtr> Downloaders;
+        typedef boost::asio::executor_work_guard<boost::asio::io_context::executor_type> WorkGuard;
+
+    private:
+        CDownloaderSettings _settings;
+        boost::asio::io_context _ioContext;
+        WorkGuard _workGuard;
+        // shared by downloaders of all hosts
+        CDnsCache _dnsCache;
+        // accessed only from io context thread
+        Downloaders _downloaders;
+        std::unique_ptr<CReplayCorpus> _ptrRecordCorpus;
+        std::thread _thread;
+    };
+}
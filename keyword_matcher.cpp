@@ -0,0 +1,303 @@
+#include <queue>
+#include <algorithm>
+#include "keyword_matcher.h"
+
+namespace watchList
+{
+namespace detail
+{
+    // half-width katakana and punctuation from U+FF61 to U+FF9F
+    const char32_t FULL_WIDTH_KATAKANA[] =
+    {
+        0x3002, 0x300C, 0x300D, 0x3001, 0x30FB, 0x30F2, 0x30A1, 0x30A3, 0x30A5, 0x30A7, 0x30A9, 0x30E3, 0x30E5, 0x30E7, 0x30C3, 0x30FC,
+        0x30A2, 0x30A4, 0x30A6, 0x30A8, 0x30AA, 0x30AB, 0x30AD, 0x30AF, 0x30B1, 0x30B3, 0x30B5, 0x30B7, 0x30B9, 0x30BB, 0x30BD, 0x30BF,
+        0x30C1, 0x30C4, 0x30C6, 0x30C8, 0x30CA, 0x30CB, 0x30CC, 0x30CD, 0x30CE, 0x30CF, 0x30D2, 0x30D5, 0x30D8, 0x30DB, 0x30DE, 0x30DF,
+        0x30E0, 0x30E1, 0x30E2, 0x30E4, 0x30E6, 0x30E8, 0x30E9, 0x30EA, 0x30EB, 0x30EC, 0x30ED, 0x30EF, 0x30F3, 0x309B, 0x309C
+    };
+
+    const char32_t HALF_WIDTH_VOICED_SOUND_MARK = 0xFF9E;
+    const char32_t HALF_WIDTH_SEMI_VOICED_SOUND_MARK = 0xFF9F;
+
+    // invalid sequence is taken byte by byte
+    char32_t decodeUtf8(std::string_view text, std::size_t* pos)
+    {
+        auto byte = [&text](std::size_t index) { return static_cast<unsigned char>(text[index]); };
+        unsigned char first = byte(*pos);
+        std::size_t length = (first < 0x80) ? 1 : ((first >> 5) == 0x6) ? 2 : ((first >> 4) == 0xE) ? 3 : ((first >> 3) == 0x1E) ? 4 : 0;
+        if ((length == 0) || (*pos + length > text.size()))
+        {
+            ++*pos;
+            return first;
+        }
+
+        char32_t codePoint = (length == 1) ? first : (first & (0xFF >> (length + 1)));
+        for (std::size_t index = 1; index < length; ++index)
+        {
+            if ((byte(*pos + index) >> 6) != 0x2)
+            {
+                ++*pos;
+                return first;
+            }
+            codePoint = (codePoint << 6) | (byte(*pos + index) & 0x3F);
+        }
+        *pos += length;
+        return codePoint;
+    }
+
+    void encodeUtf8(char32_t codePoint, std::string& text)
+    {
+        if (codePoint < 0x80)
+        {
+            text += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800)
+        {
+            text += static_cast<char>(0xC0 | (codePoint >> 6));
+            text += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000)
+        {
+            text += static_cast<char>(0xE0 | (codePoint >> 12));
+            text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            text += static_cast<char>(0xF0 | (codePoint >> 18));
+            text += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool isAsciiAlphanumeric(char ch)
+    {
+        return ((ch >= '0') && (ch <= '9')) || ((ch >= 'a') && (ch <= 'z')) || ((ch >= 'A') && (ch <= 'Z'));
+    }
+
+    // ha to ho row, ha, pa and ba follow each other
+    bool isSemiVoiceable(char32_t katakana)
+    {
+        return (katakana >= 0x30CF) && (katakana <= 0x30DB) && ((katakana - 0x30CF) % 3 == 0);
+    }
+
+    // ka to to and ha to ho rows, their voiced kana follow them
+    bool isVoiceable(char32_t katakana)
+    {
+        bool isKaToTo = (katakana >= 0x30AB) && (katakana <= 0x30C8) && (katakana != 0x30C3)
+            && (((katakana < 0x30C3) && (katakana % 2 == 1)) || ((katakana > 0x30C3) && (katakana % 2 == 0)));
+        return isKaToTo || isSemiVoiceable(katakana);
+    }
+}
+
+CKeywordMatcher::CKeywordMatcher(const std::vector<std::string>& keywords)
+    : _nodes(1)
+{
+    for (std::size_t keywordIndex = 0; keywordIndex < keywords.size(); ++keywordIndex)
+    {
+        Keyword keyword = parseKeyword(keywords[keywordIndex]);
+        KeywordWordIds keywordWordIds;
+        for (const std::string& word : keyword.words)
+        {
+            std::size_t wordId = addWord(word);
+            keywordWordIds.words.push_back(wordId);
+            _wordKeywords[wordId].push_back(keywordIndex);
+        }
+        for (const std::string& word : keyword.excludedWords)
+        {
+            keywordWordIds.excludedWords.push_back(addWord(word));
+        }
+        _keywords.push_back(std::move(keywordWordIds));
+    }
+    buildFailureLinks();
+}
+
+std::size_t CKeywordMatcher::addWord(const std::string& word)
+{
+    auto itWord = _wordIds.find(word);
+    if (itWord != _wordIds.end())
+    {
+        return itWord->second;
+    }
+
+    std::size_t wordId = _wordIds.size();
+    _wordIds.emplace(word, wordId);
+    _wordSizes.push_back(word.size());
+    _wordKeywords.emplace_back();
+    std::size_t node = 0;
+    for (char ch : word)
+    {
+        auto itChild = _nodes[node].children.find(static_cast<unsigned char>(ch));
+        if (itChild == _nodes[node].children.end())
+        {
+            _nodes[node].children.emplace(static_cast<unsigned char>(ch), _nodes.size());
+            node = _nodes.size();
+            _nodes.emplace_back();
+        }
+        else
+        {
+            node = itChild->second;
+        }
+    }
+    _nodes[node].wordIds.push_back(wordId);
+    return wordId;
+}
+
+void CKeywordMatcher::buildFailureLinks()
+{
+    // breadth first, so failure node of a node is complete before it
+    std::queue<std::size_t> nodes;
+    for (const auto& [ch, child] : _nodes.front().children)
+    {
+        nodes.push(child);
+    }
+    while (!nodes.empty())
+    {
+        std::size_t node = nodes.front();
+        nodes.pop();
+        for (const auto& [ch, child] : _nodes[node].children)
+        {
+            std::size_t failure = _nodes[node].failure;
+            while ((failure != 0) && (_nodes[failure].children.count(ch) == 0))
+            {
+                failure = _nodes[failure].failure;
+            }
+            auto itFailureChild = _nodes[failure].children.find(ch);
+            _nodes[child].failure = (itFailureChild != _nodes[failure].children.end()) ? itFailureChild->second : 0;
+            const std::vector<std::size_t>& failureWordIds = _nodes[_nodes[child].failure].wordIds;
+            _nodes[child].wordIds.insert(_nodes[child].wordIds.end(), failureWordIds.begin(), failureWordIds.end());
+            nodes.push(child);
+        }
+    }
+}
+
+std::vector<std::size_t> CKeywordMatcher::match(std::string_view text) const
+{
+    std::string normalizedText = normalize(text);
+    std::vector<bool> isWordFound(_wordIds.size(), false);
+    std::size_t node = 0;
+    for (std::size_t pos = 0; pos < normalizedText.size(); ++pos)
+    {
+        auto byte = static_cast<unsigned char>(normalizedText[pos]);
+        while ((node != 0) && (_nodes[node].children.count(byte) == 0))
+        {
+            node = _nodes[node].failure;
+        }
+        auto itChild = _nodes[node].children.find(byte);
+        node = (itChild != _nodes[node].children.end()) ? itChild->second : 0;
+        for (std::size_t wordId : _nodes[node].wordIds)
+        {
+            if (!isWordFound[wordId] && isWholeWord(normalizedText, pos + 1 - _wordSizes[wordId], pos + 1))
+            {
+                isWordFound[wordId] = true;
+            }
+        }
+    }
+
+    // only keywords with one of found words are checked
+    std::vector<std::size_t> keywordIndexes;
+    for (std::size_t wordId = 0; wordId < isWordFound.size(); ++wordId)
+    {
+        if (isWordFound[wordId])
+        {
+            keywordIndexes.insert(keywordIndexes.end(), _wordKeywords[wordId].begin(), _wordKeywords[wordId].end());
+        }
+    }
+    std::sort(keywordIndexes.begin(), keywordIndexes.end());
+    keywordIndexes.erase(std::unique(keywordIndexes.begin(), keywordIndexes.end()), keywordIndexes.end());
+
+    auto isFound = [&isWordFound](std::size_t wordId) { return isWordFound[wordId]; };
+    auto itMatchedEnd = std::remove_if(keywordIndexes.begin(), keywordIndexes.end(),
+        [this, &isFound](std::size_t keywordIndex)
+        {
+            const KeywordWordIds& keyword = _keywords[keywordIndex];
+            return !std::all_of(keyword.words.begin(), keyword.words.end(), isFound)
+                || std::any_of(keyword.excludedWords.begin(), keyword.excludedWords.end(), isFound);
+        });
+    keywordIndexes.erase(itMatchedEnd, keywordIndexes.end());
+    return keywordIndexes;
+}
+
+bool CKeywordMatcher::isWholeWord(std::string_view text, std::size_t wordStart, std::size_t wordEnd)
+{
+    bool isStartCut = (wordStart > 0) && detail::isAsciiAlphanumeric(text[wordStart]) && detail::isAsciiAlphanumeric(text[wordStart - 1]);
+    bool isEndCut = (wordEnd < text.size()) && detail::isAsciiAlphanumeric(text[wordEnd - 1]) && detail::isAsciiAlphanumeric(text[wordEnd]);
+    return !isStartCut && !isEndCut;
+}
+
+CKeywordMatcher::Keyword CKeywordMatcher::parseKeyword(std::string_view keyword)
+{
+    Keyword parsedKeyword;
+    std::string normalizedKeyword = normalize(keyword);
+    std::string_view words(normalizedKeyword);
+    while (!words.empty())
+    {
+        std::size_t wordEnd = std::min(words.find(' '), words.size());
+        std::string_view word = words.substr(0, wordEnd);
+        words.remove_prefix(std::min(wordEnd + 1, words.size()));
+        if ((word.size() > 1) && (word.front() == '-'))
+        {
+            parsedKeyword.excludedWords.emplace_back(word.substr(1));
+        }
+        else if (!word.empty())
+        {
+            parsedKeyword.words.emplace_back(word);
+        }
+    }
+    return parsedKeyword;
+}
+
+std::string CKeywordMatcher::normalize(std::string_view text)
+{
+    std::string normalizedText;
+    normalizedText.reserve(text.size());
+    std::size_t pos = 0;
+    while (pos < text.size())
+    {
+        std::size_t startPos = pos;
+        char32_t codePoint = detail::decodeUtf8(text, &pos);
+        if ((pos == startPos + 1) && (codePoint >= 0x80))
+        {
+            // byte of invalid sequence is kept as is
+            normalizedText += text[startPos];
+            continue;
+        }
+        if ((codePoint >= 0xFF01) && (codePoint <= 0xFF5E))
+        {
+            codePoint -= 0xFEE0;
+        }
+        else if (codePoint == 0x3000)
+        {
+            codePoint = ' ';
+        }
+        else if ((codePoint >= 0xFF61) && (codePoint <= 0xFF9F))
+        {
+            codePoint = detail::FULL_WIDTH_KATAKANA[codePoint - 0xFF61];
+            std::size_t nextPos = pos;
+            char32_t nextCodePoint = (nextPos < text.size()) ? detail::decodeUtf8(text, &nextPos) : 0;
+            if ((nextCodePoint == detail::HALF_WIDTH_VOICED_SOUND_MARK) && (codePoint == 0x30A6))
+            {
+                codePoint = 0x30F4;
+                pos = nextPos;
+            }
+            else if ((nextCodePoint == detail::HALF_WIDTH_VOICED_SOUND_MARK) && detail::isVoiceable(codePoint))
+            {
+                codePoint += 1;
+                pos = nextPos;
+            }
+            else if ((nextCodePoint == detail::HALF_WIDTH_SEMI_VOICED_SOUND_MARK) && detail::isSemiVoiceable(codePoint))
+            {
+                codePoint += 2;
+                pos = nextPos;
+            }
+        }
+
+        if ((codePoint >= 'A') && (codePoint <= 'Z'))
+        {
+            codePoint += 'a' - 'A';
+        }
+        detail::encodeUtf8(codePoint, normalizedText);
+    }
+    return normalizedText;
+}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace watchList
+{
+    // Finds all keywords in text at once with Aho-Corasick automaton of their words.
+    // Keyword matches when text has all of its words and none of its excluded words, e.g. "-mp3".
+    // Word is found only as a whole word, ascii letter or digit at its edge can't be next to another one,
+    // e.g. "mp3" isn't found in "mp3s". Japanese has no spaces, so other characters are found anywhere.
+    // Keywords and text are normalized, so case and width of characters don't matter.
+    class CKeywordMatcher
+    {
+    public:
+        struct Keyword
+        {
+            // normalized
+            std::vector<std::string> words;
+            std::vector<std::string> excludedWords;
+        };
+
+    public:
+        CKeywordMatcher(const std::vector<std::string>& keywords);
+
+    public:
+        // indexes of matched keywords in ascending order
+        std::vector<std::size_t> match(std::string_view text) const;
+
+        static Keyword parseKeyword(std::string_view keyword);
+        // Full-width ascii and ideographic space become half-width, half-width katakana becomes full-width one
+        // with its voiced sound mark, ascii letters become lowercase.
+        static std::string normalize(std::string_view text);
+
+    private:
+        struct Node
+        {
+            std::map<unsigned char, std::size_t> children;
+            std::size_t failure = 0;
+            // words which end here, including ones of failure nodes
+            std::vector<std::size_t> wordIds;
+        };
+
+        struct KeywordWordIds
+        {
+            std::vector<std::size_t> words;
+            std::vector<std::size_t> excludedWords;
+        };
+
+    private:
+        std::size_t addWord(const std::string& word);
+        void buildFailureLinks();
+
+        // text from wordStart to wordEnd isn't a part of longer ascii word
+        static bool isWholeWord(std::string_view text, std::size_t wordStart, std::size_t wordEnd);
+
+    private:
+        std::vector<Node> _nodes;
+        std::map<std::string, std::size_t> _wordIds;
+        std::vector<std::size_t> _wordSizes;
+        std::vector<KeywordWordIds> _keywords;
+        // keywords which have the word, excluded words aren't counted
+        std::vector<std::vector<std::size_t>> _wordKeywords;
+    };
+}
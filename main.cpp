@@ -2,13 +2,19 @@
 #include <boost/date_time.hpp>
 #include <boost/system/system_error.hpp>
 #include <boost/exception/diagnostic_information.hpp> 
+#include <boost/asio/post.hpp>
+#include <boost/asio/executor_work_guard.hpp>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <map>
 #include <set>
 #include <thread>
-#include <queue>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include <future>
 #include <filesystem>
 #include "NLTemplate.h"
 #include "app_settings.h"
@@ -18,10 +24,13 @@
 #include "yahoo_auction_info.h"
 #include "yahoo_search_query.h"
 #include "yahoo_url_factory.h"
+#include "yahoo_keyword_batch.h"
 #include "json_pretty_print.h"
 #include "async_https_downloader.h"
 #include "web_engine_downloader.h"
 #include "cmd_line_params_parser.h"
+#include "shutdown_signal.h"
+#include "file_watcher.h"
 #include <boost/algorithm/string/replace.hpp>
 
 using namespace watchList;
@@ -128,19 +137,62 @@ static std::string getWatchHistoryFileName(std::filesystem::path inputFileName,
 class CDownloadTask
 {
 public:
-    CDownloadTask(std::string_view url, std::string_view responseName, CWebEngineDownloader& downloader, bool isContinueLastSession);
+    // called from downloader thread, or at once for the page of the last session
+    typedef std::function<void()> ReadyHandler;
+
+public:
+    CDownloadTask(std::string_view url, std::string_view responseName, const CResponseCutoff& cutoff, int priority = 0, int deadlineSeconds = 0,
+        const CCancellationToken& cancellationToken = CCancellationToken());
+
+public:
+    void start(CWebEngineDownloader& downloader, bool isContinueLastSession, ReadyHandler handler);
+    // query of the task is removed from watchlist while it runs
+    bool isCancelled() const;
     
 protected:
-    bool readResponse(std::stringstream& response);
+    bool readResponse(std::string& response);
+    // the next start downloads this page instead
+    void setPage(std::string_view url, std::string_view responseName);
     
 private:
-    CWebEngineDownloader::FutureResponseType _responsePath;
+    static void readResponseFile(const std::string& responsePath, std::string& response);
+    
+private:
+    std::string _url;
+    std::string _responseName;
+    CResponseCutoff _cutoff;
+    int _priority;
+    int _deadlineSeconds;
+    CCancellationToken _cancellationToken;
+    CWebEngineDownloader::FutureResponseType _response;
     std::string _responsePathReady;    
 };
 
-CDownloadTask::CDownloadTask(std::string_view url, std::string_view responseName, CWebEngineDownloader& downloader, bool isContinueLastSession)
+CDownloadTask::CDownloadTask(std::string_view url, std::string_view responseName, const CResponseCutoff& cutoff, int priority, int deadlineSeconds,
+    const CCancellationToken& cancellationToken)
+    : _url(url)
+    , _responseName(responseName)
+    , _cutoff(cutoff)
+    , _priority(priority)
+    , _deadlineSeconds(deadlineSeconds)
+    , _cancellationToken(cancellationToken)
+{
+}
+
+bool CDownloadTask::isCancelled() const
 {
-    std::string responseNameWithExt(responseName);
+    return _cancellationToken.isCancelled();
+}
+
+void CDownloadTask::setPage(std::string_view url, std::string_view responseName)
+{
+    _url = url;
+    _responseName = responseName;
+}
+
+void CDownloadTask::start(CWebEngineDownloader& downloader, bool isContinueLastSession, ReadyHandler handler)
+{
+    std::string responseNameWithExt(_responseName);
     //responseNameWithExt += ".html";
 
     _responsePathReady = DOWNLOADS_DIR + responseNameWithExt;    
@@ -149,26 +201,46 @@ CDownloadTask::CDownloadTask(std::string_view url, std::string_view responseName
     if (isAddDownload)
     {
         _responsePathReady.clear();
-        _responsePath = downloader.addDownload(url, responseName);
+        CWebEngineDownloader::TimePoint deadline = (_deadlineSeconds > 0)
+            ? std::chrono::steady_clock::now() + std::chrono::seconds(_deadlineSeconds)
+            : CWebEngineDownloader::TimePoint::max();
+        downloader.addDownload(_url,
+            [this, handler = std::move(handler)](CWebEngineDownloader::FutureResponseType&& response)
+            {
+                _response = std::move(response);
+                handler();
+            },
+            _responseName, _priority, deadline, _cancellationToken, _cutoff);
     }
+    else
+    {
+        handler();
+    }
+}
+
+void CDownloadTask::readResponseFile(const std::string& responsePath, std::string& response)
+{
+    std::ifstream responseFile;
+    responseFile.exceptions(std::ios::failbit | std::ios::badbit);
+    responseFile.open(responsePath, std::ios::binary);
+    
+    response.resize(std::filesystem::file_size(responsePath));
+    responseFile.read(response.data(), response.size());
 }
 
-bool CDownloadTask::readResponse(std::stringstream& response)
+bool CDownloadTask::readResponse(std::string& response)
 {
     try
     {
-        std::ifstream responseFile;
-        responseFile.exceptions(std::ios::failbit | std::ios::badbit);
-        
         if (_responsePathReady.empty())
         {
-            _responsePathReady = _responsePath.get();
+            response = _response.get();
+        }
+        else
+        {
+            // page was downloaded by the last session
+            readResponseFile(_responsePathReady, response);
         }
-        
-        responseFile.open(_responsePathReady);
-
-        std::copy(std::istreambuf_iterator<char>(responseFile), std::istreambuf_iterator<char>(), std::ostreambuf_iterator(response));
-        
         return true;
     }
     catch (const std::exception& ex)
@@ -181,49 +253,167 @@ bool CDownloadTask::readResponse(std::stringstream& response)
 class CYahooAuctionsTask : public CDownloadTask
 {
 public:
-    typedef std::queue<CYahooAuctionsTask> Queue;
-    
+    typedef std::list<CYahooAuctionsTask> List;
+
 public:
-    CYahooAuctionsTask(const CYahooSearchQuery& searchQuery, CWebEngineDownloader& downloader, bool isContinueLastSession);
+    CYahooAuctionsTask(const CYahooSearchQuery& searchQuery, const CCancellationToken& cancellationToken = CCancellationToken());
+    // Download of several queries goes on when one of them is cancelled, results of cancelled queries are dropped instead.
+    // Token of each query of batch is given in order of queries.
+    CYahooAuctionsTask(const CYahooKeywordBatch& batch, const std::vector<CCancellationToken>& cancellationTokens);
     
-    void doTask(YahooSearchQueryResults& searchQueryResults, WatchHistory& watchHistory, bool isIgnoreHistory);
+    // Runs on parse thread as soon as the page is ready, watch history is only read there.
+    // Returns true if the next page has to be downloaded, i.e. all auctions of the page are new.
+    bool parse(const WatchHistory& watchHistory, bool isIgnoreHistory);
+    // tasks are added in order, so auction found by several searches goes to the first one of them
+    void addResults(YahooSearchQueryResults& searchQueryResults, WatchHistory& watchHistory, bool isIgnoreHistory);
     
 private:
     static int maxNewAuctionsToWatch;    
+    // quiet keyword usually has a few new auctions, busy one gets larger pages after the first one
+    static int firstPageSize;
+    static int nextPageSize;
+    static int maxPages;
+    // category gets much more new auctions than keyword
+    static int maxFeedPages;
+
+private:
+    static int getFirstPageSize(const CYahooKeywordBatch& batch);
+    // download of batch is cancelled when all of its queries are cancelled
+    static CCancellationToken createBatchCancellationToken(const std::vector<CCancellationToken>& cancellationTokens);
     
 private:
-    CYahooSearchQuery _searchQuery;
+    CYahooKeywordBatch _batch;
+    std::vector<CCancellationToken> _cancellationTokens;
+    // new auctions of each query of batch
+    std::vector<CYahooAuctionInfo::List> _auctions;
+    // new auctions of batch which match none of its keywords
+    std::vector<std::string> _unmatchedAuctionIds;
+    int _firstAuction;
+    int _pageSize;
+    int _numPages;
 };
 
-CYahooAuctionsTask::CYahooAuctionsTask(const CYahooSearchQuery& searchQuery, CWebEngineDownloader& downloader, bool isContinueLastSession)
-    : CDownloadTask(CYahooUrlFactory::createUrl(searchQuery), searchQuery.createResponseName(), downloader, isContinueLastSession) 
-    , _searchQuery(searchQuery)
+CYahooAuctionsTask::CYahooAuctionsTask(const CYahooSearchQuery& searchQuery, const CCancellationToken& cancellationToken)
+    : CYahooAuctionsTask(CYahooKeywordBatch(searchQuery), std::vector<CCancellationToken>(1, cancellationToken))
+{
+}
+
+CYahooAuctionsTask::CYahooAuctionsTask(const CYahooKeywordBatch& batch, const std::vector<CCancellationToken>& cancellationTokens)
+    : CDownloadTask(CYahooUrlFactory::createUrl(batch, 1, getFirstPageSize(batch)), batch.createResponseName(),
+        CYahooAuctionInfoHtmlParser::getResponseCutoff(), batch.getSearchQuery().getPriority(), batch.getSearchQuery().getDeadlineSeconds(),
+        createBatchCancellationToken(cancellationTokens))
+    , _batch(batch)
+    , _cancellationTokens(cancellationTokens)
+    , _auctions(batch.getSearchQueries().size())
+    , _firstAuction(1)
+    , _pageSize(getFirstPageSize(batch))
+    , _numPages(1)
 {
 }
 
+CCancellationToken CYahooAuctionsTask::createBatchCancellationToken(const std::vector<CCancellationToken>& cancellationTokens)
+{
+    if (cancellationTokens.size() == 1)
+    {
+        return cancellationTokens.front();
+    }
+    CCancellationToken batchCancellationToken;
+    auto ptrNumActiveQueries = std::make_shared<std::atomic<std::size_t>>(cancellationTokens.size());
+    for (const CCancellationToken& cancellationToken : cancellationTokens)
+    {
+        // tokens live for one cycle, so their callbacks go away with them
+        cancellationToken.subscribe(
+            [batchCancellationToken, ptrNumActiveQueries]()
+            {
+                if (--*ptrNumActiveQueries == 0)
+                {
+                    batchCancellationToken.cancel();
+                }
+            });
+    }
+    return batchCancellationToken;
+}
+
+int CYahooAuctionsTask::getFirstPageSize(const CYahooKeywordBatch& batch)
+{
+    return batch.isCategoryFeed() ? nextPageSize : firstPageSize;
+}
+
 int CYahooAuctionsTask::maxNewAuctionsToWatch = 10;
+int CYahooAuctionsTask::firstPageSize = 20;
+int CYahooAuctionsTask::nextPageSize = 100;
+int CYahooAuctionsTask::maxPages = 10;
+int CYahooAuctionsTask::maxFeedPages = 50;
 
-void CYahooAuctionsTask::doTask(YahooSearchQueryResults& searchQueryResults, WatchHistory& watchHistory, bool isIgnoreHistory)
+bool CYahooAuctionsTask::parse(const WatchHistory& watchHistory, bool isIgnoreHistory)
 {
-    std::stringstream response;
-    if (readResponse(response))
+    std::string response;
+    if (!readResponse(response))
+    {
+        std::cerr << "Search of keyword " << _batch.createResponseName() << " is skipped" << std::endl;
+        return false;
+    }
+
+    CYahooAuctionInfoHtmlParser parser(std::move(response));
+    int numAuctions = 0;
+    bool isKnownAuctionFound = false;
+    while (parser.hasNext())
+    {
+        const CYahooAuctionInfo& auctionInfo = parser.next();
+        ++numAuctions;
+        if (!isIgnoreHistory && (watchHistory.count(auctionInfo.getId()) != 0))
+        {
+            isKnownAuctionFound = true;
+            continue;
+        }
+
+        std::vector<std::size_t> queryIndexes = _batch.match(auctionInfo.getTitle());
+        for (std::size_t queryIndex : queryIndexes)
+        {
+            _auctions[queryIndex].emplace_back(auctionInfo);
+        }
+        if (queryIndexes.empty())
+        {
+            _unmatchedAuctionIds.push_back(auctionInfo.getId());
+        }
+    }
+
+    // Auctions are sorted by start time, so ones after the known auction have been seen by the previous run.
+    // Without history only the first page is shown anyway, short page is the last one.
+    int numPagesLimit = _batch.isCategoryFeed() ? maxFeedPages : maxPages;
+    if (isIgnoreHistory || isKnownAuctionFound || (numAuctions < _pageSize) || (_numPages >= numPagesLimit))
+    {
+        return false;
+    }
+    _firstAuction += _pageSize;
+    _pageSize = nextPageSize;
+    ++_numPages;
+    setPage(CYahooUrlFactory::createUrl(_batch, _firstAuction, _pageSize), _batch.createResponseName() + " " + std::to_string(_numPages));
+    return true;
+}
+
+void CYahooAuctionsTask::addResults(YahooSearchQueryResults& searchQueryResults, WatchHistory& watchHistory, bool isIgnoreHistory)
+{
+    const std::vector<CYahooSearchQuery>& searchQueries = _batch.getSearchQueries();
+    for (std::size_t queryIndex = 0; queryIndex < searchQueries.size(); ++queryIndex)
     {
+        if (_cancellationTokens[queryIndex].isCancelled())
+        {
+            continue;
+        }
         CYahooAuctionInfo::List newAuctions;
-        CYahooAuctionInfoHtmlParser parser(response);
-        while (parser.hasNext())
+        for (CYahooAuctionInfo& auctionInfo : _auctions[queryIndex])
         {
-            const CYahooAuctionInfo& auctionInfo = parser.next();
-            if (isIgnoreHistory || (watchHistory.count(auctionInfo.getId()) == 0))
+            bool isNewAuction = watchHistory.insert(auctionInfo.getId()).second;
+            if (isIgnoreHistory ? (newAuctions.size() < maxNewAuctionsToWatch) : isNewAuction)
             {
-                if (!isIgnoreHistory || (newAuctions.size() < maxNewAuctionsToWatch))
-                {
-                    newAuctions.emplace_back(auctionInfo);
-                }
-                watchHistory.insert(auctionInfo.getId());
-            }      
+                newAuctions.emplace_back(std::move(auctionInfo));
+            }
         }
-        insertYahooAuctions(searchQueryResults, std::move(_searchQuery), std::move(newAuctions));
+        insertYahooAuctions(searchQueryResults, CYahooSearchQuery(searchQueries[queryIndex]), std::move(newAuctions));
     }
+    // the next run stops paging of batch at them as well
+    watchHistory.insert(_unmatchedAuctionIds.begin(), _unmatchedAuctionIds.end());
 }
 
 static void printWatchHistoryFile(const std::string& watchHistoryFileName, const WatchHistory& watchHistory)
@@ -277,7 +467,13 @@ static void createYahooHtmlFile(const YahooSearchQueryResults& searchQueryResult
                 
             searchQueryNode.set("injapanSearchLink", CInjapanUrlFactory::createUrl(searchQuery));
             searchQueryNode.set("keyword", searchQuery.getKeyword());
-            searchQueryNode.set("category", searchQuery.getCategoryName());
+            // injapan search link doesn't apply the filter, so label shows it
+            std::string categoryLabel = searchQuery.getCategoryName();
+            if (!searchQuery.getFilter().isEmpty())
+            {
+                categoryLabel += ", " + searchQuery.getFilter().createName();
+            }
+            searchQueryNode.set("category", categoryLabel);
             searchQueryNode.set("numMatches", std::to_string(newAuctions.size()));
                     
             std::size_t newAuctionCount = 0;
@@ -301,14 +497,60 @@ static void createYahooHtmlFile(const YahooSearchQueryResults& searchQueryResult
     }
 }
 
-template <typename T, typename... Args>
-static void doTasks(std::queue<T>& tasks, Args&&... args)
+// Task keeps parse threads running until its page is handed over. Next page of the task is started from parse thread.
+template <typename T>
+static void startTask(T& task, CWebEngineDownloader& downloader, bool isContinueLastSession, asio::io_context& parseContext,
+    const WatchHistory& watchHistory, bool isIgnoreHistory)
 {
-    while (!tasks.empty())
+    task.start(downloader, isContinueLastSession,
+        [&task, &downloader, isContinueLastSession, &parseContext, &watchHistory, isIgnoreHistory,
+            taskWorkGuard = asio::make_work_guard(parseContext)]() mutable
+        {
+            asio::post(parseContext,
+                [&task, &downloader, isContinueLastSession, &parseContext, &watchHistory, isIgnoreHistory]()
+                {
+                    try
+                    {
+                        // download of cancelled task fails anyway
+                        if (!task.isCancelled() && task.parse(watchHistory, isIgnoreHistory))
+                        {
+                            startTask(task, downloader, isContinueLastSession, parseContext, watchHistory, isIgnoreHistory);
+                        }
+                    }
+                    catch (const std::exception& ex)
+                    {
+                        std::cerr << ex.what() << std::endl;
+                    }
+                });
+            taskWorkGuard.reset();
+        });
+}
+
+// Pages are parsed on worker threads in order their downloads complete, so a slow page doesn't hold up the rest.
+// Results are added in order of tasks afterwards, which keeps them the same as in sequential run.
+template <typename T, typename Results>
+static void doTasks(std::list<T>& tasks, CWebEngineDownloader& downloader, bool isContinueLastSession, Results& results,
+    WatchHistory& watchHistory, bool isIgnoreHistory)
+{
+    asio::io_context parseContext;
+    auto workGuard = asio::make_work_guard(parseContext);
+    CThreadList parseThreads;
+    parseThreads.run(parseContext);
+
+    for (T& task : tasks)
     {
-        tasks.front().doTask(std::forward<Args>(args)...);
-        tasks.pop();
-    }    
+        startTask(task, downloader, isContinueLastSession, parseContext, watchHistory, isIgnoreHistory);
+    }
+    workGuard.reset();
+    parseThreads.join();
+
+    for (T& task : tasks)
+    {
+        if (!task.isCancelled())
+        {
+            task.addResults(results, watchHistory, isIgnoreHistory);
+        }
+    }
 }
 
 static WatchHistory getWatchHistory(const std::string& watchHistoryFileName)
@@ -352,33 +594,364 @@ static void prepareDownloader(CWebEngineDownloader& downloader, bool isContinueL
     downloader.setDownloadDir(DOWNLOADS_DIR);
 }
 
-static void createYahooAuctionsHtml(const std::string& keywordsFileName, const std::string& watchHistoryFileName, bool isContinueLastSession)
-{          
-    CYahooAuctionsTask::Queue tasks;
-    CWebEngineDownloader downloader;
-    CYahooKeywordsFileSearchQueryParser searchQueryParser(keywordsFileName);
-    while (searchQueryParser.hasNext())
+// Watchlist stays in memory between polling cycles of daemon, so its queries and watch history are loaded only once
+class CWatchList
+{
+public:
+    typedef std::unique_ptr<CWatchList> UniquePtr;
+
+public:
+    CWatchList(const std::string& queriesFileName, std::string_view watchListName, std::chrono::minutes pollInterval,
+        CWebEngineDownloader& downloader);
+    virtual ~CWatchList() = default;
+
+public:
+    const std::string& getQueriesFileName() const;
+    std::chrono::minutes getPollInterval() const;
+    // downloads of current cycle are cancelled with the token, e.g. by shutdown signal
+    void setShutdownCancellationToken(const CCancellationToken& cancellationToken);
+
+    // downloads pages of all queries, saves watch history and renders report of new items
+    void runCycle(bool isContinueLastSession);
+    // downloads pages of queries added by the last reload only, others keep their schedule
+    void runReloadCycle();
+
+    // Called from file watcher thread when queries file is changed. Downloads of removed queries are cancelled at once,
+    // added queries wait for reload cycle.
+    virtual void reloadQueries() = 0;
+    virtual bool isReloadPending() const = 0;
+
+protected:
+    virtual void doCycle(bool isContinueLastSession, bool isIgnoreHistory, bool isReloadCycle, std::size_t* numQueries,
+        std::size_t* numResults) = 0;
+
+protected:
+    std::string _queriesFileName;
+    std::string _watchListName;
+    CWebEngineDownloader& _downloader;
+    WatchHistory _watchHistory;
+    CCancellationToken _shutdownCancellationToken;
+
+private:
+    void runCycle(bool isContinueLastSession, bool isReloadCycle);
+
+private:
+    std::chrono::minutes _pollInterval;
+    std::string _watchHistoryFileName;
+};
+
+CWatchList::CWatchList(const std::string& queriesFileName, std::string_view watchListName, std::chrono::minutes pollInterval,
+    CWebEngineDownloader& downloader)
+    : _queriesFileName(queriesFileName)
+    , _watchListName(watchListName)
+    , _downloader(downloader)
+    , _pollInterval(pollInterval)
+    , _watchHistoryFileName(getWatchHistoryFileName(queriesFileName, watchListName))
+{
+    if (std::filesystem::exists(_watchHistoryFileName))
+    {
+        _watchHistory = getWatchHistory(_watchHistoryFileName);
+    }
+}
+
+const std::string& CWatchList::getQueriesFileName() const
+{
+    return _queriesFileName;
+}
+
+std::chrono::minutes CWatchList::getPollInterval() const
+{
+    return _pollInterval;
+}
+
+void CWatchList::setShutdownCancellationToken(const CCancellationToken& cancellationToken)
+{
+    _shutdownCancellationToken = cancellationToken;
+}
+
+void CWatchList::runCycle(bool isContinueLastSession)
+{
+    runCycle(isContinueLastSession, false);
+}
+
+void CWatchList::runReloadCycle()
+{
+    runCycle(false, true);
+}
+
+void CWatchList::runCycle(bool isContinueLastSession, bool isReloadCycle)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    bool isIgnoreHistory = _watchHistory.empty();
+    std::size_t numQueries = 0;
+    std::size_t numResults = 0;
+    doCycle(isContinueLastSession, isIgnoreHistory, isReloadCycle, &numQueries, &numResults);
+    if (isReloadCycle && (numQueries == 0))
+    {
+        // only removed queries, or nothing changed at all
+        return;
+    }
+    printWatchHistoryFile(_watchHistoryFileName, _watchHistory);
+
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+    std::cout << posix_time::second_clock::local_time() << " " << _watchListName << ": " << numResults << " of " << numQueries
+        << ((isReloadCycle) ? " added" : "") << " queries have new items, cycle took " << duration.count() << " s" << std::endl;
+}
+
+// Keeps queries of watchlist and a cancellation token for each of them, so reload of queries file touches only
+// the queries which are added or removed there. Task is created from one query and adds its results to Results.
+template <typename Query, typename Task, typename Results>
+class CQueryWatchList : public CWatchList
+{
+public:
+    void reloadQueries() override;
+    bool isReloadPending() const override;
+
+protected:
+    typedef std::vector<Query> Queries;
+
+protected:
+    CQueryWatchList(const std::string& queriesFileName, std::string_view watchListName, std::chrono::minutes pollInterval,
+        CWebEngineDownloader& downloader);
+
+    // derived class calls it from its constructor, queries file is parsed by loadQueries
+    void load();
+    virtual Queries loadQueries() const = 0;
+    virtual void render(const Results& results) const = 0;
+    // one task per query, derived class may pack several queries into one task, tokens are given in order of queries
+    virtual void addTasks(const Queries& queries, const std::vector<CCancellationToken>& cancellationTokens,
+        typename Task::List* tasks) const;
+
+    void doCycle(bool isContinueLastSession, bool isIgnoreHistory, bool isReloadCycle, std::size_t* numQueries,
+        std::size_t* numResults) override;
+
+private:
+    typedef std::map<Query, CCancellationToken> CancellationTokens;
+
+private:
+    // Takes queries to download in this cycle with their tokens, full cycle applies pending reload first.
+    // Reload which comes later cancels the tokens of queries it removes.
+    Queries takeQueries(bool isReloadCycle, std::vector<CCancellationToken>* cancellationTokens);
+    void addCancellationTokens(const Queries& queries);
+
+private:
+    mutable std::mutex _mutex;
+    // queries of file in file order, without queries of pending reload
+    Queries _queries;
+    // empty if no reload is pending
+    std::optional<Queries> _reloadedQueries;
+    // tokens of queries of file and of pending reload
+    CancellationTokens _cancellationTokens;
+};
+
+template <typename Query, typename Task, typename Results>
+CQueryWatchList<Query, Task, Results>::CQueryWatchList(const std::string& queriesFileName, std::string_view watchListName,
+    std::chrono::minutes pollInterval, CWebEngineDownloader& downloader)
+    : CWatchList(queriesFileName, watchListName, pollInterval, downloader)
+{
+}
+
+template <typename Query, typename Task, typename Results>
+void CQueryWatchList<Query, Task, Results>::load()
+{
+    _queries = loadQueries();
+    addCancellationTokens(_queries);
+}
+
+template <typename Query, typename Task, typename Results>
+void CQueryWatchList<Query, Task, Results>::addCancellationTokens(const Queries& queries)
+{
+    for (const Query& query : queries)
+    {
+        _cancellationTokens.emplace(query, CCancellationToken());
+    }
+}
+
+template <typename Query, typename Task, typename Results>
+void CQueryWatchList<Query, Task, Results>::reloadQueries()
+{
+    Queries queries;
+    try
+    {
+        queries = loadQueries();
+    }
+    catch (const std::exception& ex)
+    {
+        // file may be broken in the middle of editing, old queries stay until it is fixed
+        std::cerr << "Can't reload " << _queriesFileName << ": " << ex.what() << std::endl;
+        return;
+    }
+
+    std::set<Query> newQueries(queries.begin(), queries.end());
+    std::unique_lock lock(_mutex);
+    std::set<Query> oldQueries(_queries.begin(), _queries.end());
+    auto numAdded = std::count_if(newQueries.begin(), newQueries.end(), [&oldQueries](const Query& query) { return oldQueries.count(query) == 0; });
+    auto numRemoved = std::count_if(oldQueries.begin(), oldQueries.end(), [&newQueries](const Query& query) { return newQueries.count(query) == 0; });
+    for (auto it = _cancellationTokens.begin(); it != _cancellationTokens.end();)
+    {
+        if (newQueries.count(it->first) == 0)
+        {
+            it->second.cancel();
+            it = _cancellationTokens.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    addCancellationTokens(queries);
+    _reloadedQueries = std::move(queries);
+    std::cout << posix_time::second_clock::local_time() << " " << _watchListName << ": " << numAdded << " queries added, "
+        << numRemoved << " removed" << std::endl;
+}
+
+template <typename Query, typename Task, typename Results>
+void CQueryWatchList<Query, Task, Results>::addTasks(const Queries& queries, const std::vector<CCancellationToken>& cancellationTokens,
+    typename Task::List* tasks) const
+{
+    for (std::size_t queryIndex = 0; queryIndex < queries.size(); ++queryIndex)
     {
-        tasks.emplace(searchQueryParser.next(), downloader, isContinueLastSession);        
+        tasks->emplace_back(queries[queryIndex], cancellationTokens[queryIndex]);
     }
-    prepareDownloader(downloader, isContinueLastSession);    
-   
-    YahooSearchQueryResults searchQueryResults;
-    WatchHistory watchHistory;
-    if (std::filesystem::exists(watchHistoryFileName))
+}
+
+template <typename Query, typename Task, typename Results>
+bool CQueryWatchList<Query, Task, Results>::isReloadPending() const
+{
+    std::unique_lock lock(_mutex);
+    return _reloadedQueries.has_value();
+}
+
+template <typename Query, typename Task, typename Results>
+typename CQueryWatchList<Query, Task, Results>::Queries CQueryWatchList<Query, Task, Results>::takeQueries(bool isReloadCycle,
+    std::vector<CCancellationToken>* cancellationTokens)
+{
+    std::unique_lock lock(_mutex);
+    Queries queries;
+    if (!_reloadedQueries)
+    {
+        queries = isReloadCycle ? Queries() : _queries;
+    }
+    else
+    {
+        // full cycle downloads added queries as well
+        std::set<Query> oldQueries(_queries.begin(), _queries.end());
+        std::copy_if(_reloadedQueries->begin(), _reloadedQueries->end(), std::back_inserter(queries),
+            [&oldQueries, isReloadCycle](const Query& query) { return !isReloadCycle || (oldQueries.count(query) == 0); });
+        _queries = std::move(*_reloadedQueries);
+        _reloadedQueries.reset();
+    }
+
+    for (const Query& query : queries)
+    {
+        cancellationTokens->push_back(_cancellationTokens.at(query));
+    }
+    return queries;
+}
+
+template <typename Query, typename Task, typename Results>
+void CQueryWatchList<Query, Task, Results>::doCycle(bool isContinueLastSession, bool isIgnoreHistory, bool isReloadCycle,
+    std::size_t* numQueries, std::size_t* numResults)
+{
+    std::vector<CCancellationToken> queryCancellationTokens;
+    Queries queries = takeQueries(isReloadCycle, &queryCancellationTokens);
+    if (isReloadCycle && queries.empty())
+    {
+        return;
+    }
+
+    // downloads subscribe to tokens of this cycle, so tokens of queries don't collect their callbacks over the daemon run
+    std::vector<CCancellationToken> cancellationTokens(queries.size());
+    std::vector<CCancellationToken::SubscriptionId> subscriptionIds;
+    for (std::size_t queryIndex = 0; queryIndex < queries.size(); ++queryIndex)
+    {
+        subscriptionIds.push_back(queryCancellationTokens[queryIndex].subscribe(
+            [cancellationToken = cancellationTokens[queryIndex]]() { cancellationToken.cancel(); }));
+    }
+    CCancellationToken::SubscriptionId shutdownSubscriptionId = _shutdownCancellationToken.subscribe(
+        [cancellationTokens]()
+        {
+            for (const CCancellationToken& cancellationToken : cancellationTokens)
+            {
+                cancellationToken.cancel();
+            }
+        });
+
+    typename Task::List tasks;
+    addTasks(queries, cancellationTokens, &tasks);
+    Results results;
+    doTasks(tasks, _downloader, isContinueLastSession, results, _watchHistory, isIgnoreHistory);
+    for (std::size_t queryIndex = 0; queryIndex < queries.size(); ++queryIndex)
+    {
+        queryCancellationTokens[queryIndex].unsubscribe(subscriptionIds[queryIndex]);
+    }
+    _shutdownCancellationToken.unsubscribe(shutdownSubscriptionId);
+    render(results);
+    *numQueries = queries.size();
+    *numResults = results.size();
+}
+
+class CYahooWatchList : public CQueryWatchList<CYahooSearchQuery, CYahooAuctionsTask, YahooSearchQueryResults>
+{
+public:
+    // category feed downloads the newest auctions of categories and matches all keywords in their titles as whole words
+    CYahooWatchList(const std::string& keywordsFileName, bool isCategoryFeed, std::chrono::minutes pollInterval,
+        CWebEngineDownloader& downloader);
+
+protected:
+    Queries loadQueries() const override;
+    void render(const YahooSearchQueryResults& searchQueryResults) const override;
+    // keywords of title searches are downloaded in batches
+    void addTasks(const Queries& searchQueries, const std::vector<CCancellationToken>& cancellationTokens,
+        CYahooAuctionsTask::List* tasks) const override;
+
+private:
+    bool _isCategoryFeed;
+};
+
+CYahooWatchList::CYahooWatchList(const std::string& keywordsFileName, bool isCategoryFeed, std::chrono::minutes pollInterval,
+    CWebEngineDownloader& downloader)
+    : CQueryWatchList(keywordsFileName, "yahoo", pollInterval, downloader)
+    , _isCategoryFeed(isCategoryFeed)
+{
+    load();
+}
+
+CYahooWatchList::Queries CYahooWatchList::loadQueries() const
+{
+    Queries searchQueries;
+    CYahooKeywordsFileSearchQueryParser searchQueryParser(_queriesFileName);
+    while (searchQueryParser.hasNext())
     {
-        watchHistory = getWatchHistory(watchHistoryFileName);
+        searchQueries.push_back(searchQueryParser.next());
     }
-    bool isIgnoreHistory = watchHistory.empty();
-    doTasks(tasks, searchQueryResults, watchHistory, isIgnoreHistory);
-    printWatchHistoryFile(watchHistoryFileName, watchHistory);
-    createYahooHtmlFile(searchQueryResults, keywordsFileName);
+    return searchQueries;
 }
 
-static void watchYahooAuctions(const std::string& keywordsFileName, bool isContinueLastSession)
+void CYahooWatchList::render(const YahooSearchQueryResults& searchQueryResults) const
 {
-    std::string watchHistoryFileName = getWatchHistoryFileName(keywordsFileName, "yahoo");
-    createYahooAuctionsHtml(keywordsFileName, watchHistoryFileName, isContinueLastSession);
+    createYahooHtmlFile(searchQueryResults, _queriesFileName);
+}
+
+void CYahooWatchList::addTasks(const Queries& searchQueries, const std::vector<CCancellationToken>& cancellationTokens,
+    CYahooAuctionsTask::List* tasks) const
+{
+    std::map<CYahooSearchQuery, CCancellationToken> queryCancellationTokens;
+    for (std::size_t queryIndex = 0; queryIndex < searchQueries.size(); ++queryIndex)
+    {
+        queryCancellationTokens.emplace(searchQueries[queryIndex], cancellationTokens[queryIndex]);
+    }
+    CYahooKeywordBatch::List batches = _isCategoryFeed ? CYahooKeywordBatch::planCategoryFeeds(searchQueries)
+        : CYahooKeywordBatch::plan(searchQueries);
+    for (const CYahooKeywordBatch& batch : batches)
+    {
+        std::vector<CCancellationToken> batchCancellationTokens;
+        for (const CYahooSearchQuery& searchQuery : batch.getSearchQueries())
+        {
+            batchCancellationTokens.push_back(queryCancellationTokens.at(searchQuery));
+        }
+        tasks->emplace_back(batch, batchCancellationTokens);
+    }
 }
 
 static void createDiskunionHtmlFile(const DiskunionItemQueryResults& itemQueryResults, const std::string& itemsFileName)
@@ -448,71 +1021,132 @@ static void createDiskunionHtmlFile(const DiskunionItemQueryResults& itemQueryRe
 class CDiskunionAddAllItemsTask : public CDownloadTask
 {
 public:
-    typedef std::queue<CDiskunionAddAllItemsTask> Queue;
+    typedef std::list<CDiskunionAddAllItemsTask> List;
 
 public:
-    CDiskunionAddAllItemsTask(const CDiskunionItemQuery& itemQuery, CWebEngineDownloader& downloader, bool isContinueLastSession);
+    CDiskunionAddAllItemsTask(const CDiskunionItemQuery& itemQuery, const CCancellationToken& cancellationToken = CCancellationToken());
     
-    void doTask(DiskunionItemQueryResults& itemQueryResults, WatchHistory& watchHistory, bool isIgnoreHistory);
+    // runs on parse thread as soon as the page is ready, watch history is only read there, item has one page only
+    bool parse(const WatchHistory& watchHistory, bool isIgnoreHistory);
+    void addResults(DiskunionItemQueryResults& itemQueryResults, WatchHistory& watchHistory, bool isIgnoreHistory);
     
 private:
     CDiskunionItemQuery _itemQuery;
+    // empty if page isn't downloaded
+    std::optional<CDiskunionItemInfo> _itemInfo;
     CWebEngineDownloader::FutureResponseType _responsePath;
     std::string _responsePathReady;
 };
 
-CDiskunionAddAllItemsTask::CDiskunionAddAllItemsTask(const CDiskunionItemQuery& itemQuery, CWebEngineDownloader& downloader, bool isContinueLastSession)
-    : CDownloadTask(itemQuery.getUrl(), itemQuery.getCode(), downloader, isContinueLastSession)
+CDiskunionAddAllItemsTask::CDiskunionAddAllItemsTask(const CDiskunionItemQuery& itemQuery, const CCancellationToken& cancellationToken)
+    : CDownloadTask(itemQuery.getUrl(), itemQuery.getCode(), CDiskunionItemInfoHtmlParser::getResponseCutoff(), 0, 0, cancellationToken)
     , _itemQuery(itemQuery)
 {
 }
 
-void CDiskunionAddAllItemsTask::doTask(DiskunionItemQueryResults& itemQueryResults, WatchHistory& watchHistory, bool isIgnoreHistory)
+bool CDiskunionAddAllItemsTask::parse(const WatchHistory& watchHistory, bool isIgnoreHistory)
 {
-    std::stringstream response;
-    readResponse(response);
-
-    CDiskunionItemInfoHtmlParser parser(response);
-    CDiskunionItemInfo itemInfo(parser);
-    while (parser.hasNextUsedItem())
+    std::string response;
+    if (readResponse(response))
     {
-        const CDiskunionUsedItemInfo& usedItemInfo = parser.nextUsedItem();
-        if (isIgnoreHistory || (watchHistory.count(usedItemInfo.getId()) == 0))
+        CDiskunionItemInfoHtmlParser parser(std::move(response));
+        _itemInfo.emplace(parser);
+        while (parser.hasNextUsedItem())
         {
-            itemInfo.getUsedItems().emplace_back(usedItemInfo);
-            watchHistory.insert(usedItemInfo.getId());            
+            const CDiskunionUsedItemInfo& usedItemInfo = parser.nextUsedItem();
+            if (isIgnoreHistory || (watchHistory.count(usedItemInfo.getId()) == 0))
+            {
+                _itemInfo->getUsedItems().emplace_back(usedItemInfo);
+            }
         }
     }
-    insertDiskunionItems(itemQueryResults, std::move(_itemQuery), std::move(itemInfo));
+    return false;
 }
 
-static void createDiskunionItemsHtml(const std::string& itemsFileName, const std::string& watchHistoryFileName, bool isContinueLastSession)
+void CDiskunionAddAllItemsTask::addResults(DiskunionItemQueryResults& itemQueryResults, WatchHistory& watchHistory, bool isIgnoreHistory)
 {
-    CDiskunionAddAllItemsTask::Queue tasks;
-    CWebEngineDownloader downloader;
-    CDiskunionFileItemQueryParser parser(itemsFileName);
-    while (parser.hasNext())
+    if (_itemInfo)
     {
-        tasks.emplace(parser.next(), downloader, isContinueLastSession);
+        CDiskunionUsedItemInfo::List& usedItems = _itemInfo->getUsedItems();
+        auto newUsedItemsEnd = usedItems.begin();
+        for (CDiskunionUsedItemInfo& usedItemInfo : usedItems)
+        {
+            // the same used item may be listed by several items
+            if (watchHistory.insert(usedItemInfo.getId()).second || isIgnoreHistory)
+            {
+                *newUsedItemsEnd++ = std::move(usedItemInfo);
+            }
+        }
+        usedItems.erase(newUsedItemsEnd, usedItems.end());
+        insertDiskunionItems(itemQueryResults, std::move(_itemQuery), std::move(*_itemInfo));
     }
-    prepareDownloader(downloader, isContinueLastSession);
+}
+
+class CDiskunionWatchList : public CQueryWatchList<CDiskunionItemQuery, CDiskunionAddAllItemsTask, DiskunionItemQueryResults>
+{
+public:
+    CDiskunionWatchList(const std::string& itemsFileName, std::chrono::minutes pollInterval, CWebEngineDownloader& downloader);
+
+protected:
+    Queries loadQueries() const override;
+    void render(const DiskunionItemQueryResults& itemQueryResults) const override;
+};
 
-    DiskunionItemQueryResults itemQueryResults;
-    WatchHistory watchHistory;
-    if (std::filesystem::exists(watchHistoryFileName))
+CDiskunionWatchList::CDiskunionWatchList(const std::string& itemsFileName, std::chrono::minutes pollInterval, CWebEngineDownloader& downloader)
+    : CQueryWatchList(itemsFileName, "diskunion", pollInterval, downloader)
+{
+    load();
+}
+
+CDiskunionWatchList::Queries CDiskunionWatchList::loadQueries() const
+{
+    Queries itemQueries;
+    CDiskunionFileItemQueryParser parser(_queriesFileName);
+    while (parser.hasNext())
     {
-        watchHistory = getWatchHistory(watchHistoryFileName);
+        itemQueries.push_back(parser.next());
     }
-    bool isIgnoreHistory = watchHistory.empty();
-    doTasks(tasks, itemQueryResults, watchHistory, isIgnoreHistory);
-    printWatchHistoryFile(watchHistoryFileName, watchHistory);
-    createDiskunionHtmlFile(itemQueryResults, itemsFileName);    
+    return itemQueries;
 }
 
-static void watchDiskunionItems(const std::string& diskunionItemsFileName, bool isContinueLastSession)
+void CDiskunionWatchList::render(const DiskunionItemQueryResults& itemQueryResults) const
 {
-    std::string watchHistoryFileName = getWatchHistoryFileName(diskunionItemsFileName, "diskunion");
-    createDiskunionItemsHtml(diskunionItemsFileName, watchHistoryFileName, isContinueLastSession);
+    createDiskunionHtmlFile(itemQueryResults, _queriesFileName);
+}
+
+// Without shutdown signal watchlist runs one cycle, daemon repeats cycles at poll interval of watchlist until it is stopped.
+// Cycle which is late because the previous one took too long starts at once. Reload of queries file wakes daemon up
+// before the cycle time, then only added queries are downloaded.
+static void runWatchList(CWatchList& watchList, bool isContinueLastSession, CShutdownSignal* ptrShutdownSignal)
+{
+    if (ptrShutdownSignal == nullptr)
+    {
+        watchList.runCycle(isContinueLastSession);
+        return;
+    }
+
+    auto cycleTime = std::chrono::steady_clock::now();
+    while (ptrShutdownSignal->waitUntil(cycleTime, [&watchList]() { return watchList.isReloadPending(); }))
+    {
+        try
+        {
+            if (std::chrono::steady_clock::now() >= cycleTime)
+            {
+                cycleTime += watchList.getPollInterval();
+                watchList.runCycle(isContinueLastSession);
+                // only the first cycle continues the last session
+                isContinueLastSession = false;
+            }
+            // file may be changed during the full cycle as well
+            watchList.runReloadCycle();
+        }
+        catch (const std::exception& ex)
+        {
+            // the next cycle may succeed, e.g. after network is back
+            std::cerr << ex.what() << std::endl;
+        }
+        cycleTime = std::max(cycleTime, std::chrono::steady_clock::now());
+    }
 }
 
 static void bookmarksToDiskunionItems()
@@ -555,13 +1189,69 @@ int main(int argCount, char** argValues)
     try
     {
         CCmdLineParamsParser parser(argCount, argValues);
+        // signals are taken over before downloader starts its threads
+        std::optional<CShutdownSignal> shutdownSignal;
+        if (parser.isDaemon())
+        {
+            shutdownSignal.emplace();
+        }
+        CShutdownSignal* ptrShutdownSignal = shutdownSignal ? &*shutdownSignal : nullptr;
+
+        // watches share downloader, so hosts of both are scheduled together and downloads dir is prepared once
+        CWebEngineDownloader downloader;
+        downloader.setSettings(parser.getDownloaderSettings());
+        prepareDownloader(downloader, parser.isContinueLastSession());
+
+        std::vector<CWatchList::UniquePtr> watchLists;
         if (parser.isWatchYahoo())
         {
-            watchYahooAuctions(parser.getYahooKeywordsFilePath(), parser.isContinueLastSession());
+            watchLists.push_back(std::make_unique<CYahooWatchList>(parser.getYahooKeywordsFilePath(), parser.isYahooCategoryFeed(),
+                parser.getYahooPollInterval(), downloader));
         }
         if (parser.isWatchDiskunion())
         {
-            watchDiskunionItems(parser.getDiskunionItemsFilePath(), parser.isContinueLastSession());
+            watchLists.push_back(std::make_unique<CDiskunionWatchList>(parser.getDiskunionItemsFilePath(), parser.getDiskunionPollInterval(),
+                downloader));
+        }
+
+        if (ptrShutdownSignal != nullptr)
+        {
+            for (auto& ptrWatchList : watchLists)
+            {
+                ptrWatchList->setShutdownCancellationToken(ptrShutdownSignal->getCancellationToken());
+            }
+        }
+
+        // stops before watchlists are gone, so its handlers don't outlive them
+        std::optional<CFileWatcher> fileWatcher;
+        if (parser.isWatchFiles())
+        {
+            fileWatcher.emplace();
+            for (auto& ptrWatchList : watchLists)
+            {
+                fileWatcher->watch(ptrWatchList->getQueriesFileName(),
+                    [&watchList = *ptrWatchList, ptrShutdownSignal]()
+                    {
+                        watchList.reloadQueries();
+                        ptrShutdownSignal->wakeUp();
+                    });
+            }
+        }
+
+        // watches go to different hosts, so they run at once, the first error is reported after both are done
+        std::vector<std::future<void>> watches;
+        for (auto& ptrWatchList : watchLists)
+        {
+            watches.push_back(std::async(std::launch::async, runWatchList, std::ref(*ptrWatchList), parser.isContinueLastSession(),
+                ptrShutdownSignal));
+        }
+        for (auto& watch : watches)
+        {
+            watch.wait();
+        }
+        for (auto& watch : watches)
+        {
+            watch.get();
         }
     }
     catch (const std::exception& ex)
@@ -0,0 +1,137 @@
+#include <fstream>
+#include <charconv>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include "replay_corpus.h"
+
+namespace watchList
+{
+std::string_view CReplayCorpus::INDEX_FILE_NAME = "index.txt";
+std::string_view CReplayCorpus::PAGE_FILE_EXTENSION = ".html";
+
+CReplayCorpus::CReplayCorpus(const std::string& dirPath)
+    : _dirPath(dirPath)
+    , _lastFileNumber(0)
+{
+}
+
+std::string CReplayCorpus::readPage(const std::string& fileName) const
+{
+    std::filesystem::path pagePath = std::filesystem::path(_dirPath) / fileName;
+    std::ifstream pageFile;
+    pageFile.exceptions(std::ios::failbit | std::ios::badbit);
+    pageFile.open(pagePath, std::ios::binary);
+
+    std::string content;
+    content.resize(std::filesystem::file_size(pagePath));
+    pageFile.read(content.data(), content.size());
+    return content;
+}
+
+void CReplayCorpus::insertPage(std::string_view key, std::string&& content)
+{
+    Pages& pages = (!key.empty() && (key.back() == '*')) ? _prefixPages : _pages;
+    if (&pages == &_prefixPages)
+    {
+        key.remove_suffix(1);
+    }
+    pages.insert_or_assign(std::string(key), std::move(content));
+}
+
+bool CReplayCorpus::hasIndex() const
+{
+    return std::filesystem::exists(std::filesystem::path(_dirPath) / INDEX_FILE_NAME);
+}
+
+void CReplayCorpus::load()
+{
+    std::filesystem::path indexPath = std::filesystem::path(_dirPath) / INDEX_FILE_NAME;
+    std::ifstream indexFile(indexPath);
+    if (!indexFile.is_open())
+    {
+        throw std::runtime_error("Cannot open replay corpus index " + indexPath.string());
+    }
+
+    std::string line;
+    while (std::getline(indexFile, line))
+    {
+        std::string_view lineView(line);
+        // target may contain spaces of keywords, file name may not
+        std::size_t fileNamePos = lineView.find_last_of(" \t");
+        if ((fileNamePos != std::string::npos) && (fileNamePos != 0))
+        {
+            std::string fileName(lineView.substr(fileNamePos + 1));
+            try
+            {
+                insertPage(lineView.substr(0, fileNamePos), readPage(fileName));
+            }
+            catch (const std::exception& ex)
+            {
+                throw std::runtime_error("Cannot read replay page " + fileName + " : " + ex.what());
+            }
+            // new pages of recording continue numbering after recorded ones
+            int fileNumber = 0;
+            std::from_chars(fileName.data(), fileName.data() + fileName.size(), fileNumber);
+            _lastFileNumber = std::max(_lastFileNumber, fileNumber);
+        }
+    }
+}
+
+const std::string* CReplayCorpus::findPage(std::string_view host, std::string_view target) const
+{
+    std::string key(host);
+    key += target;
+
+    auto it = _pages.find(key);
+    if (it != _pages.end())
+    {
+        return &it->second;
+    }
+
+    // the longest prefix is the most specific one
+    const std::string* ptrPage = nullptr;
+    std::size_t prefixSize = 0;
+    for (const auto& [prefix, content] : _prefixPages)
+    {
+        if ((prefix.size() >= prefixSize) && (key.compare(0, prefix.size(), prefix) == 0))
+        {
+            ptrPage = &content;
+            prefixSize = prefix.size();
+        }
+    }
+    return ptrPage;
+}
+
+void CReplayCorpus::addPage(std::string_view host, std::string_view target, std::string_view content)
+{
+    std::string key(host);
+    key += target;
+    if (_pages.count(key) != 0)
+    {
+        return;
+    }
+
+    std::filesystem::create_directories(_dirPath);
+
+    std::string fileName;
+    do
+    {
+        fileName = std::to_string(++_lastFileNumber);
+        fileName += PAGE_FILE_EXTENSION;
+    }
+    while (std::filesystem::exists(std::filesystem::path(_dirPath) / fileName));
+
+    std::ofstream pageFile;
+    pageFile.exceptions(std::ios::failbit | std::ios::badbit);
+    pageFile.open(std::filesystem::path(_dirPath) / fileName, std::ios::binary);
+    pageFile.write(content.data(), content.size());
+
+    std::ofstream indexFile;
+    indexFile.exceptions(std::ios::failbit | std::ios::badbit);
+    indexFile.open(std::filesystem::path(_dirPath) / INDEX_FILE_NAME, std::ios::app);
+    indexFile << key << " " << fileName << std::endl;
+
+    insertPage(key, std::string(content));
+}
+}
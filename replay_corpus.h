@@ -0,0 +1,50 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <cstddef>
+
+namespace watchList
+{
+    // Recorded pages served by replay server instead of real hosts.
+    // Index file of corpus directory has line "<host><target> <file name>" for every page,
+    // key ending with "*" matches all targets starting with it, later lines override earlier ones.
+    class CReplayCorpus
+    {
+    public:
+        CReplayCorpus(const std::string& dirPath);
+
+    public:
+        bool hasIndex() const;
+        // throws runtime_error if index or its pages can't be read
+        void load();
+
+        // nullptr if page of host isn't recorded
+        const std::string* findPage(std::string_view host, std::string_view target) const;
+
+        // writes page to a new file of corpus directory and appends it to index, page which is already recorded is kept
+        void addPage(std::string_view host, std::string_view target, std::string_view content);
+
+        std::size_t getNumPages() const
+            { return _pages.size() + _prefixPages.size(); }
+
+    private:
+        static std::string_view INDEX_FILE_NAME;
+        static std::string_view PAGE_FILE_EXTENSION;
+
+    private:
+        typedef std::map<std::string, std::string, std::less<>> Pages;
+
+    private:
+        std::string readPage(const std::string& fileName) const;
+        void insertPage(std::string_view key, std::string&& content);
+
+    private:
+        std::string _dirPath;
+        Pages _pages;
+        // pages matched by key prefix, e.g. one search page for all queries
+        Pages _prefixPages;
+        // the highest number of page file names
+        int _lastFileNumber;
+    };
+}
@@ -0,0 +1,96 @@
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include "replay_profile.h"
+
+namespace watchList
+{
+std::string_view CReplayProfile::PARAM_NAME_LATENCY = "-latency:";
+std::string_view CReplayProfile::PARAM_NAME_JITTER = "-jitter:";
+std::string_view CReplayProfile::PARAM_NAME_BANDWIDTH = "-bandwidth:";
+std::string_view CReplayProfile::PARAM_NAME_ERRORS = "-errors:";
+std::string_view CReplayProfile::PARAM_NAME_RATE = "-rate:";
+std::string_view CReplayProfile::PARAM_NAME_BURST = "-burst:";
+
+CReplayProfile::CReplayProfile()
+    : _latencyMs(0)
+    , _jitterMs(0)
+    , _bandwidthKbPerSecond(0.0)
+    , _errorRate(0.0)
+    , _requestsPerSecond(0.0)
+    , _burst(1.0)
+{
+}
+
+void CReplayProfile::parse(std::string_view line, std::string_view paramName, double& value)
+{
+    std::size_t paramPos = line.find(paramName);
+    if (paramPos != std::string::npos)
+    {
+        auto first = line.begin() + paramPos + paramName.size();
+        auto last = std::find_if(first, line.end(), ::isspace);
+        value = std::stod(std::string(first, last));
+    }
+}
+
+void CReplayProfile::parse(std::string_view line)
+{
+    double latencyMs = _latencyMs;
+    parse(line, PARAM_NAME_LATENCY, latencyMs);
+    _latencyMs = static_cast<int>(latencyMs);
+
+    double jitterMs = _jitterMs;
+    parse(line, PARAM_NAME_JITTER, jitterMs);
+    _jitterMs = static_cast<int>(jitterMs);
+
+    parse(line, PARAM_NAME_BANDWIDTH, _bandwidthKbPerSecond);
+    parse(line, PARAM_NAME_ERRORS, _errorRate);
+    parse(line, PARAM_NAME_RATE, _requestsPerSecond);
+    parse(line, PARAM_NAME_BURST, _burst);
+}
+
+const CReplayProfile& CReplayProfiles::getProfile(std::string_view host) const
+{
+    while (!host.empty())
+    {
+        auto it = _profiles.find(host);
+        if (it != _profiles.end())
+        {
+            return it->second;
+        }
+        std::size_t dotPos = host.find('.');
+        host = (dotPos == std::string::npos) ? std::string_view() : host.substr(dotPos + 1);
+    }
+    return _defaultProfile;
+}
+
+void CReplayProfiles::load(const std::string& profilesFilePath)
+{
+    std::ifstream profilesFile(profilesFilePath);
+    if (!profilesFile.is_open())
+    {
+        throw std::runtime_error("Cannot open replay profiles " + profilesFilePath);
+    }
+
+    std::string line;
+    while (std::getline(profilesFile, line))
+    {
+        std::string_view lineView(line);
+        std::size_t hostEndPos = lineView.find_first_of(" \t");
+        std::string_view host = lineView.substr(0, hostEndPos);
+        if (!host.empty() && (host.front() != '#'))
+        {
+            if (host == "*")
+            {
+                _defaultProfile.parse(lineView);
+            }
+            else
+            {
+                // hosts listed after default profile inherit its values
+                auto it = _profiles.emplace(host, _defaultProfile).first;
+                it->second.parse(lineView);
+            }
+        }
+    }
+}
+}
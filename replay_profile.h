@@ -0,0 +1,78 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+namespace watchList
+{
+    // How replay server imitates a host: response delay, link speed, failures and rate limit.
+    class CReplayProfile
+    {
+    public:
+        CReplayProfile();
+
+    public:
+        // delay before response header, random jitter up to given value is added to it
+        int getLatencyMs() const
+            { return _latencyMs; }
+
+        int getJitterMs() const
+            { return _jitterMs; }
+
+        // zero means no limit
+        double getBandwidthKbPerSecond() const
+            { return _bandwidthKbPerSecond; }
+
+        // fraction of requests which fail with server error, reset or truncated body
+        double getErrorRate() const
+            { return _errorRate; }
+
+        // requests above the rate get 429, zero means no limit
+        double getRequestsPerSecond() const
+            { return _requestsPerSecond; }
+
+        double getBurst() const
+            { return _burst; }
+
+    public:
+        void parse(std::string_view line);
+
+    private:
+        static std::string_view PARAM_NAME_LATENCY;
+        static std::string_view PARAM_NAME_JITTER;
+        static std::string_view PARAM_NAME_BANDWIDTH;
+        static std::string_view PARAM_NAME_ERRORS;
+        static std::string_view PARAM_NAME_RATE;
+        static std::string_view PARAM_NAME_BURST;
+
+    private:
+        static void parse(std::string_view line, std::string_view paramName, double& value);
+
+    private:
+        int _latencyMs;
+        int _jitterMs;
+        double _bandwidthKbPerSecond;
+        double _errorRate;
+        double _requestsPerSecond;
+        double _burst;
+    };
+
+    class CReplayProfiles
+    {
+    public:
+        // profile of the domain applies to all its subdomains
+        const CReplayProfile& getProfile(std::string_view host) const;
+
+    public:
+        // Every line of file is "<host> -latency:<ms> -jitter:<ms> -bandwidth:<KB per second> -errors:<fraction>
+        // -rate:<requests per second> -burst:<requests>", host "*" sets default profile.
+        void load(const std::string& profilesFilePath);
+
+    private:
+        typedef std::map<std::string, CReplayProfile, std::less<>> Profiles;
+
+    private:
+        CReplayProfile _defaultProfile;
+        Profiles _profiles;
+    };
+}
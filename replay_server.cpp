@@ -0,0 +1,870 @@
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/http/read.hpp>
+#include <boost/beast/http/write.hpp>
+#include <boost/beast/version.hpp>
+#include <nghttp2/nghttp2.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <memory>
+#include "replay_server.h"
+
+using namespace boost::asio;
+using namespace boost::beast;
+using namespace boost::system;
+
+namespace watchList
+{
+static std::string_view NONE_REPLAY_FAULT_STR = "none";
+static std::string_view SERVER_ERROR_REPLAY_FAULT_STR = "server error";
+static std::string_view UNAVAILABLE_REPLAY_FAULT_STR = "unavailable";
+static std::string_view RESET_REPLAY_FAULT_STR = "reset";
+static std::string_view TRUNCATE_REPLAY_FAULT_STR = "truncate";
+// server preference, h2 goes first
+static std::string_view ALPN_PROTOCOLS = "\x02h2\x08http/1.1";
+
+std::string_view getReplayFault(EReplayFault fault)
+{
+    switch (fault)
+    {
+        case EReplayFault::NONE:
+            return NONE_REPLAY_FAULT_STR;
+        case EReplayFault::SERVER_ERROR:
+            return SERVER_ERROR_REPLAY_FAULT_STR;
+        case EReplayFault::UNAVAILABLE:
+            return UNAVAILABLE_REPLAY_FAULT_STR;
+        case EReplayFault::RESET:
+            return RESET_REPLAY_FAULT_STR;
+        case EReplayFault::TRUNCATE:
+            return TRUNCATE_REPLAY_FAULT_STR;
+    }
+    return NONE_REPLAY_FAULT_STR;
+}
+
+static int onAlpnSelectCallback(SSL* /*ssl*/, const unsigned char** protocol, unsigned char* protocolSize, const unsigned char* clientProtocols,
+    unsigned int clientProtocolsSize, void* /*userData*/)
+{
+    // client without h2 or without ALPN at all gets HTTP/1.1
+    int result = SSL_select_next_proto(const_cast<unsigned char**>(protocol), protocolSize,
+        reinterpret_cast<const unsigned char*>(ALPN_PROTOCOLS.data()), ALPN_PROTOCOLS.size(), clientProtocols, clientProtocolsSize);
+    return (result == OPENSSL_NPN_NEGOTIATED) ? SSL_TLSEXT_ERR_OK : SSL_TLSEXT_ERR_NOACK;
+}
+
+static bool isHttp2Selected(SSL* ssl)
+{
+    const unsigned char* protocol = nullptr;
+    unsigned int protocolSize = 0;
+    SSL_get0_alpn_selected(ssl, &protocol, &protocolSize);
+    return std::string_view(reinterpret_cast<const char*>(protocol), protocolSize) == "h2";
+}
+
+// One client connection of HTTP/2, every stream is answered on its own with the same latency, bandwidth and faults
+// as HTTP/1.1 request. Reset fault resets the stream, other streams of connection go on.
+class CReplayServer::CHttp2Session : public std::enable_shared_from_this<CHttp2Session>
+{
+public:
+    CHttp2Session(CReplayServer* ptrServer, SslStream&& sslStream);
+    ~CHttp2Session();
+
+public:
+    void start();
+
+private:
+    struct Stream
+    {
+        typedef std::shared_ptr<Stream> SharedPtr;
+
+        Stream(io_context& ioContext, std::int32_t id);
+
+        std::int32_t id;
+        std::string host;
+        std::string target;
+        Response response;
+        EReplayFault fault;
+        std::size_t chunkSize;
+        // body which may be sent before the next write interval
+        std::size_t allowedSize;
+        std::size_t sentSize;
+        steady_timer timer;
+        Clock::time_point requestTime;
+        bool isClosed;
+    };
+
+    typedef std::map<std::int32_t, Stream::SharedPtr> Streams;
+
+private:
+    static std::uint32_t MAX_CONCURRENT_STREAMS;
+    static std::size_t READ_BUFFER_SIZE;
+
+private:
+    bool createSession();
+    void read();
+    void onRead(const error_code& errorCode, std::size_t numBytes);
+    // sends everything nghttp2 has queued
+    void flush();
+    void close();
+    void respond(Stream::SharedPtr stream);
+    void submitResponse(const Stream::SharedPtr& stream);
+    void allowNextChunk(Stream::SharedPtr stream);
+    ssize_t readBody(std::int32_t streamId, std::uint8_t* data, std::size_t size, std::uint32_t* ptrDataFlags);
+    Stream::SharedPtr getStream(std::int32_t streamId) const;
+
+    static int onBeginHeadersCallback(nghttp2_session* session, const nghttp2_frame* frame, void* userData);
+    static int onHeaderCallback(nghttp2_session* session, const nghttp2_frame* frame, const std::uint8_t* name, std::size_t nameSize,
+        const std::uint8_t* value, std::size_t valueSize, std::uint8_t flags, void* userData);
+    static int onFrameRecvCallback(nghttp2_session* session, const nghttp2_frame* frame, void* userData);
+    static int onStreamCloseCallback(nghttp2_session* session, std::int32_t streamId, std::uint32_t errorCode, void* userData);
+    static ssize_t onDataSourceReadCallback(nghttp2_session* session, std::int32_t streamId, std::uint8_t* data, std::size_t size,
+        std::uint32_t* ptrDataFlags, nghttp2_data_source* source, void* userData);
+
+private:
+    CReplayServer* _ptrServer;
+    SslStream _sslStream;
+    nghttp2_session* _session;
+    Streams _streams;
+    std::vector<char> _readBuffer;
+    std::string _writeBuffer;
+    bool _isWriting;
+    bool _isClosed;
+};
+
+std::uint32_t CReplayServer::CHttp2Session::MAX_CONCURRENT_STREAMS = 100;
+std::size_t CReplayServer::CHttp2Session::READ_BUFFER_SIZE = 16384;
+
+CReplayServer::CHttp2Session::Stream::Stream(io_context& ioContext, std::int32_t id)
+    : id(id)
+    , fault(EReplayFault::NONE)
+    , chunkSize(0)
+    , allowedSize(0)
+    , sentSize(0)
+    , timer(ioContext)
+    , isClosed(false)
+{
+}
+
+CReplayServer::CHttp2Session::CHttp2Session(CReplayServer* ptrServer, SslStream&& sslStream)
+    : _ptrServer(ptrServer)
+    , _sslStream(std::move(sslStream))
+    , _session(nullptr)
+    , _readBuffer(READ_BUFFER_SIZE)
+    , _isWriting(false)
+    , _isClosed(false)
+{
+}
+
+CReplayServer::CHttp2Session::~CHttp2Session()
+{
+    if (_session != nullptr)
+    {
+        nghttp2_session_del(_session);
+    }
+}
+
+void CReplayServer::CHttp2Session::start()
+{
+    // client keeps connection as long as it needs, slow streams are limited by profile
+    get_lowest_layer(_sslStream).expires_never();
+    if (!createSession())
+    {
+        close();
+        return;
+    }
+    flush();
+    read();
+}
+
+bool CReplayServer::CHttp2Session::createSession()
+{
+    nghttp2_session_callbacks* callbacks = nullptr;
+    if (nghttp2_session_callbacks_new(&callbacks) != 0)
+    {
+        return false;
+    }
+    nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, onBeginHeadersCallback);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, onHeaderCallback);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, onFrameRecvCallback);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, onStreamCloseCallback);
+    int result = nghttp2_session_server_new(&_session, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+    if (result != 0)
+    {
+        _session = nullptr;
+        return false;
+    }
+
+    nghttp2_settings_entry settings[] =
+    {
+        { NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, MAX_CONCURRENT_STREAMS }
+    };
+    nghttp2_submit_settings(_session, NGHTTP2_FLAG_NONE, settings, std::size(settings));
+    return true;
+}
+
+void CReplayServer::CHttp2Session::read()
+{
+    _sslStream.async_read_some(buffer(_readBuffer),
+        [ptrThis = shared_from_this()](const error_code& errorCode, std::size_t numBytes)
+        {
+            ptrThis->onRead(errorCode, numBytes);
+        });
+}
+
+void CReplayServer::CHttp2Session::onRead(const error_code& errorCode, std::size_t numBytes)
+{
+    if (_isClosed)
+    {
+        return;
+    }
+    if (errorCode || (nghttp2_session_mem_recv(_session, reinterpret_cast<const std::uint8_t*>(_readBuffer.data()), numBytes) < 0))
+    {
+        close();
+        return;
+    }
+    flush();
+    if (!_isClosed)
+    {
+        read();
+    }
+}
+
+void CReplayServer::CHttp2Session::flush()
+{
+    if (_isWriting || _isClosed)
+    {
+        return;
+    }
+
+    const std::uint8_t* data = nullptr;
+    ssize_t size = 0;
+    while ((size = nghttp2_session_mem_send(_session, &data)) > 0)
+    {
+        _writeBuffer.append(reinterpret_cast<const char*>(data), size);
+    }
+    if (size < 0)
+    {
+        close();
+        return;
+    }
+
+    if (_writeBuffer.empty())
+    {
+        // client has sent GOAWAY and all streams are finished
+        if ((nghttp2_session_want_read(_session) == 0) && (nghttp2_session_want_write(_session) == 0))
+        {
+            close();
+        }
+        return;
+    }
+
+    _ptrServer->_statistics.numBytesSent += _writeBuffer.size();
+    _isWriting = true;
+    async_write(_sslStream, buffer(_writeBuffer),
+        [ptrThis = shared_from_this()](const error_code& errorCode, std::size_t)
+        {
+            ptrThis->_isWriting = false;
+            ptrThis->_writeBuffer.clear();
+            if (errorCode)
+            {
+                ptrThis->close();
+            }
+            else
+            {
+                ptrThis->flush();
+            }
+        });
+}
+
+void CReplayServer::CHttp2Session::close()
+{
+    if (_isClosed)
+    {
+        return;
+    }
+    _isClosed = true;
+    for (auto& [streamId, stream] : _streams)
+    {
+        stream->isClosed = true;
+        stream->timer.cancel();
+    }
+    _streams.clear();
+    error_code errorCode;
+    get_lowest_layer(_sslStream).socket().close(errorCode);
+}
+
+CReplayServer::CHttp2Session::Stream::SharedPtr CReplayServer::CHttp2Session::getStream(std::int32_t streamId) const
+{
+    auto it = _streams.find(streamId);
+    return (it == _streams.end()) ? nullptr : it->second;
+}
+
+void CReplayServer::CHttp2Session::respond(Stream::SharedPtr stream)
+{
+    stream->requestTime = Clock::now();
+    std::string_view host = stream->host;
+    host = host.substr(0, host.find(':'));
+    const CReplayProfile& profile = _ptrServer->_profiles.getProfile(host);
+    stream->response = _ptrServer->createResponse(host, stream->target, 11, profile, &stream->fault);
+    stream->chunkSize = getChunkSize(profile);
+    stream->allowedSize = stream->chunkSize;
+
+    stream->timer.expires_after(_ptrServer->pickLatency(profile));
+    stream->timer.async_wait(
+        [ptrThis = shared_from_this(), stream](const error_code& errorCode)
+        {
+            if (errorCode || stream->isClosed)
+            {
+                return;
+            }
+            if (stream->fault == EReplayFault::RESET)
+            {
+                nghttp2_submit_rst_stream(ptrThis->_session, NGHTTP2_FLAG_NONE, stream->id, NGHTTP2_INTERNAL_ERROR);
+            }
+            else
+            {
+                ptrThis->submitResponse(stream);
+            }
+            ptrThis->flush();
+        });
+}
+
+void CReplayServer::CHttp2Session::submitResponse(const Stream::SharedPtr& stream)
+{
+    // HTTP/2 header names are lower case, connection header isn't allowed
+    std::string status = std::to_string(stream->response.result_int());
+    std::vector<std::pair<std::string, std::string>> fields;
+    for (const auto& field : stream->response)
+    {
+        if (field.name() != http::field::connection)
+        {
+            std::string name(field.name_string());
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+            fields.emplace_back(std::move(name), std::string(field.value()));
+        }
+    }
+
+    std::vector<nghttp2_nv> headers;
+    auto addHeader = [&headers](std::string_view name, std::string_view value)
+        {
+            // nghttp2 copies names and values while response is submitted
+            headers.push_back(nghttp2_nv{ reinterpret_cast<std::uint8_t*>(const_cast<char*>(name.data())),
+                reinterpret_cast<std::uint8_t*>(const_cast<char*>(value.data())), name.size(), value.size(), NGHTTP2_NV_FLAG_NONE });
+        };
+    addHeader(":status", status);
+    for (const auto& [name, value] : fields)
+    {
+        addHeader(name, value);
+    }
+
+    nghttp2_data_provider dataProvider;
+    dataProvider.source.ptr = nullptr;
+    dataProvider.read_callback = onDataSourceReadCallback;
+    if (nghttp2_submit_response(_session, stream->id, headers.data(), headers.size(), &dataProvider) != 0)
+    {
+        nghttp2_submit_rst_stream(_session, NGHTTP2_FLAG_NONE, stream->id, NGHTTP2_INTERNAL_ERROR);
+    }
+}
+
+void CReplayServer::CHttp2Session::allowNextChunk(Stream::SharedPtr stream)
+{
+    stream->timer.expires_after(WRITE_INTERVAL);
+    stream->timer.async_wait(
+        [ptrThis = shared_from_this(), stream](const error_code& errorCode)
+        {
+            if (errorCode || stream->isClosed)
+            {
+                return;
+            }
+            stream->allowedSize = stream->chunkSize;
+            nghttp2_session_resume_data(ptrThis->_session, stream->id);
+            ptrThis->flush();
+        });
+}
+
+ssize_t CReplayServer::CHttp2Session::readBody(std::int32_t streamId, std::uint8_t* data, std::size_t size, std::uint32_t* ptrDataFlags)
+{
+    Stream::SharedPtr stream = getStream(streamId);
+    if (stream == nullptr)
+    {
+        return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+    }
+
+    const std::string& body = stream->response.body();
+    std::size_t remainingSize = body.size() - stream->sentSize;
+    if ((remainingSize == 0) && (stream->fault == EReplayFault::TRUNCATE))
+    {
+        // stream is reset with INTERNAL_ERROR after the half of the body
+        _ptrServer->_statistics.responseTimes.push_back(Clock::now() - stream->requestTime);
+        return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+    }
+
+    std::size_t chunkSize = std::min(size, remainingSize);
+    if (stream->chunkSize != 0)
+    {
+        if ((stream->allowedSize == 0) && (chunkSize != 0))
+        {
+            allowNextChunk(stream);
+            return NGHTTP2_ERR_DEFERRED;
+        }
+        chunkSize = std::min(chunkSize, stream->allowedSize);
+        stream->allowedSize -= chunkSize;
+    }
+    std::memcpy(data, body.data() + stream->sentSize, chunkSize);
+    stream->sentSize += chunkSize;
+
+    if ((stream->sentSize == body.size()) && (stream->fault != EReplayFault::TRUNCATE))
+    {
+        *ptrDataFlags |= NGHTTP2_DATA_FLAG_EOF;
+        _ptrServer->_statistics.responseTimes.push_back(Clock::now() - stream->requestTime);
+    }
+    return chunkSize;
+}
+
+int CReplayServer::CHttp2Session::onBeginHeadersCallback(nghttp2_session* /*session*/, const nghttp2_frame* frame, void* userData)
+{
+    if ((frame->hd.type == NGHTTP2_HEADERS) && (frame->headers.cat == NGHTTP2_HCAT_REQUEST))
+    {
+        CHttp2Session* ptrThis = static_cast<CHttp2Session*>(userData);
+        ptrThis->_streams[frame->hd.stream_id] = std::make_shared<Stream>(ptrThis->_ptrServer->_ioContext, frame->hd.stream_id);
+    }
+    return 0;
+}
+
+int CReplayServer::CHttp2Session::onHeaderCallback(nghttp2_session* /*session*/, const nghttp2_frame* frame, const std::uint8_t* name,
+    std::size_t nameSize, const std::uint8_t* value, std::size_t valueSize, std::uint8_t /*flags*/, void* userData)
+{
+    CHttp2Session* ptrThis = static_cast<CHttp2Session*>(userData);
+    Stream::SharedPtr stream = ptrThis->getStream(frame->hd.stream_id);
+    if (stream == nullptr)
+    {
+        return 0;
+    }
+    std::string_view headerName(reinterpret_cast<const char*>(name), nameSize);
+    std::string_view headerValue(reinterpret_cast<const char*>(value), valueSize);
+    if ((headerName == ":authority") || ((headerName == "host") && stream->host.empty()))
+    {
+        stream->host = headerValue;
+    }
+    else if (headerName == ":path")
+    {
+        stream->target = headerValue;
+    }
+    return 0;
+}
+
+int CReplayServer::CHttp2Session::onFrameRecvCallback(nghttp2_session* /*session*/, const nghttp2_frame* frame, void* userData)
+{
+    // request is answered when it's received whole, its body isn't needed
+    bool isRequestFrame = (frame->hd.type == NGHTTP2_HEADERS) || (frame->hd.type == NGHTTP2_DATA);
+    if (isRequestFrame && ((frame->hd.flags & NGHTTP2_FLAG_END_STREAM) != 0))
+    {
+        CHttp2Session* ptrThis = static_cast<CHttp2Session*>(userData);
+        if (Stream::SharedPtr stream = ptrThis->getStream(frame->hd.stream_id))
+        {
+            ptrThis->respond(std::move(stream));
+        }
+    }
+    return 0;
+}
+
+int CReplayServer::CHttp2Session::onStreamCloseCallback(nghttp2_session* /*session*/, std::int32_t streamId, std::uint32_t /*errorCode*/,
+    void* userData)
+{
+    CHttp2Session* ptrThis = static_cast<CHttp2Session*>(userData);
+    auto it = ptrThis->_streams.find(streamId);
+    if (it != ptrThis->_streams.end())
+    {
+        it->second->isClosed = true;
+        it->second->timer.cancel();
+        ptrThis->_streams.erase(it);
+    }
+    return 0;
+}
+
+ssize_t CReplayServer::CHttp2Session::onDataSourceReadCallback(nghttp2_session* /*session*/, std::int32_t streamId, std::uint8_t* data,
+    std::size_t size, std::uint32_t* ptrDataFlags, nghttp2_data_source* /*source*/, void* userData)
+{
+    CHttp2Session* ptrThis = static_cast<CHttp2Session*>(userData);
+    return ptrThis->readBody(streamId, data, size, ptrDataFlags);
+}
+
+// One client connection, requests are answered one by one as HTTP/1.1 keep-alive allows.
+// Connection which has chosen h2 is handed over to HTTP/2 session after handshake.
+class CReplayServer::CSession : public std::enable_shared_from_this<CSession>
+{
+public:
+    CSession(CReplayServer* ptrServer, ip::tcp::socket&& socket);
+
+public:
+    void start();
+
+private:
+    static std::chrono::seconds HANDSHAKE_TIMEOUT;
+    static std::chrono::seconds IDLE_TIMEOUT;
+
+private:
+    void read();
+    void onRead(const error_code& errorCode);
+    void respond();
+    void writeResponse();
+    void write();
+    void onWrite(const error_code& errorCode, std::size_t numBytes);
+    void onResponseWritten();
+    // closes connection without TLS shutdown, as lost connection does
+    void reset();
+
+private:
+    CReplayServer* _ptrServer;
+    SslStream _sslStream;
+    flat_buffer _buffer;
+    http::request<http::string_body> _request;
+    Response _response;
+    std::optional<http::response_serializer<http::string_body>> _serializer;
+    steady_timer _timer;
+    const CReplayProfile* _ptrProfile;
+    EReplayFault _fault;
+    std::size_t _chunkSize;
+    Clock::time_point _requestTime;
+};
+
+std::chrono::seconds CReplayServer::CSession::HANDSHAKE_TIMEOUT(10);
+std::chrono::seconds CReplayServer::CSession::IDLE_TIMEOUT(60);
+
+CReplayServer::CSession::CSession(CReplayServer* ptrServer, ip::tcp::socket&& socket)
+    : _ptrServer(ptrServer)
+    , _sslStream(std::move(socket), ptrServer->_sslContext)
+    , _timer(ptrServer->_ioContext)
+    , _ptrProfile(nullptr)
+    , _fault(EReplayFault::NONE)
+    , _chunkSize(0)
+{
+}
+
+void CReplayServer::CSession::start()
+{
+    get_lowest_layer(_sslStream).expires_after(HANDSHAKE_TIMEOUT);
+    _sslStream.async_handshake(ssl::stream_base::server,
+        [ptrThis = shared_from_this()](const error_code& errorCode)
+        {
+            if (errorCode)
+            {
+                return;
+            }
+            if (isHttp2Selected(ptrThis->_sslStream.native_handle()))
+            {
+                std::make_shared<CHttp2Session>(ptrThis->_ptrServer, std::move(ptrThis->_sslStream))->start();
+            }
+            else
+            {
+                ptrThis->read();
+            }
+        });
+}
+
+void CReplayServer::CSession::read()
+{
+    _request = {};
+    get_lowest_layer(_sslStream).expires_after(IDLE_TIMEOUT);
+    http::async_read(_sslStream, _buffer, _request,
+        [ptrThis = shared_from_this()](const error_code& errorCode, std::size_t)
+        {
+            ptrThis->onRead(errorCode);
+        });
+}
+
+void CReplayServer::CSession::onRead(const error_code& errorCode)
+{
+    if (!errorCode)
+    {
+        // slow responses are limited by profile, not by timeout
+        get_lowest_layer(_sslStream).expires_never();
+        respond();
+    }
+}
+
+void CReplayServer::CSession::respond()
+{
+    _requestTime = Clock::now();
+    std::string_view host = _request[http::field::host];
+    host = host.substr(0, host.find(':'));
+    const CReplayProfile& profile = _ptrServer->_profiles.getProfile(host);
+    _ptrProfile = &profile;
+
+    _response = _ptrServer->createResponse(host, _request.target(), _request.version(), profile, &_fault);
+    _response.keep_alive(_request.keep_alive());
+
+    _timer.expires_after(_ptrServer->pickLatency(profile));
+    _timer.async_wait(
+        [ptrThis = shared_from_this()](const error_code& errorCode)
+        {
+            if (!errorCode)
+            {
+                if (ptrThis->_fault == EReplayFault::RESET)
+                {
+                    ptrThis->reset();
+                }
+                else
+                {
+                    ptrThis->writeResponse();
+                }
+            }
+        });
+}
+
+void CReplayServer::CSession::writeResponse()
+{
+    _chunkSize = getChunkSize(*_ptrProfile);
+    _serializer.emplace(_response);
+    write();
+}
+
+void CReplayServer::CSession::write()
+{
+    if (_chunkSize != 0)
+    {
+        _serializer->limit(_chunkSize);
+    }
+    http::async_write_some(_sslStream, *_serializer,
+        [ptrThis = shared_from_this()](const error_code& errorCode, std::size_t numBytes)
+        {
+            ptrThis->onWrite(errorCode, numBytes);
+        });
+}
+
+void CReplayServer::CSession::onWrite(const error_code& errorCode, std::size_t numBytes)
+{
+    if (errorCode)
+    {
+        return;
+    }
+    _ptrServer->_statistics.numBytesSent += numBytes;
+    if (!_serializer->is_done())
+    {
+        if (_chunkSize == 0)
+        {
+            write();
+        }
+        else
+        {
+            _timer.expires_after(WRITE_INTERVAL);
+            _timer.async_wait(
+                [ptrThis = shared_from_this()](const error_code& errorCode)
+                {
+                    if (!errorCode)
+                    {
+                        ptrThis->write();
+                    }
+                });
+        }
+        return;
+    }
+    onResponseWritten();
+}
+
+void CReplayServer::CSession::onResponseWritten()
+{
+    _ptrServer->_statistics.responseTimes.push_back(Clock::now() - _requestTime);
+    _serializer.reset();
+
+    if (_fault == EReplayFault::TRUNCATE)
+    {
+        reset();
+    }
+    else if (!_response.keep_alive())
+    {
+        get_lowest_layer(_sslStream).expires_after(HANDSHAKE_TIMEOUT);
+        _sslStream.async_shutdown([ptrThis = shared_from_this()](const error_code&) {});
+    }
+    else
+    {
+        read();
+    }
+}
+
+void CReplayServer::CSession::reset()
+{
+    error_code errorCode;
+    get_lowest_layer(_sslStream).socket().close(errorCode);
+}
+
+std::chrono::milliseconds CReplayServer::WRITE_INTERVAL(10);
+std::size_t CReplayServer::MIN_CHUNK_SIZE = 64;
+
+CReplayServer::CReplayServer(io_context& ioContext, ssl::context& sslContext, unsigned short port,
+    const CReplayCorpus& corpus, const CReplayProfiles& profiles, unsigned int seed)
+    : _ioContext(ioContext)
+    , _sslContext(sslContext)
+    , _acceptor(ioContext, ip::tcp::endpoint(ip::tcp::v4(), port))
+    , _corpus(corpus)
+    , _profiles(profiles)
+    , _random(seed)
+    , _startTime(Clock::now())
+{
+    SSL_CTX_set_alpn_select_cb(_sslContext.native_handle(), onAlpnSelectCallback, nullptr);
+}
+
+void CReplayServer::start()
+{
+    _startTime = Clock::now();
+    accept();
+}
+
+void CReplayServer::accept()
+{
+    _acceptor.async_accept(
+        [this](const error_code& errorCode, ip::tcp::socket socket)
+        {
+            if (!errorCode)
+            {
+                std::make_shared<CSession>(this, std::move(socket))->start();
+            }
+            if (_acceptor.is_open())
+            {
+                accept();
+            }
+        });
+}
+
+CReplayServer::Response CReplayServer::createResponse(std::string_view host, std::string_view target, unsigned int version,
+    const CReplayProfile& profile, EReplayFault* ptrFault)
+{
+    ++_statistics.numRequests;
+    Response response;
+    response.version(version);
+    response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    *ptrFault = EReplayFault::NONE;
+
+    Clock::duration waitTime = throttle(host, profile);
+    if (waitTime != Clock::duration::zero())
+    {
+        ++_statistics.numThrottled;
+        response.result(http::status::too_many_requests);
+        response.set(http::field::retry_after, std::to_string(std::chrono::ceil<std::chrono::seconds>(waitTime).count()));
+    }
+    else
+    {
+        *ptrFault = pickFault(profile);
+        if (*ptrFault == EReplayFault::SERVER_ERROR)
+        {
+            response.result(http::status::internal_server_error);
+        }
+        else if (*ptrFault == EReplayFault::UNAVAILABLE)
+        {
+            response.result(http::status::service_unavailable);
+            response.set(http::field::retry_after, "1");
+        }
+        else
+        {
+            const std::string* ptrPage = _corpus.findPage(host, target);
+            if (ptrPage == nullptr)
+            {
+                ++_statistics.numNotFound;
+                std::cerr << "Page isn't recorded: " << host << target << std::endl;
+                response.result(http::status::not_found);
+                // fault of missing page would only hide it
+                *ptrFault = EReplayFault::NONE;
+            }
+            else
+            {
+                response.result(http::status::ok);
+                response.set(http::field::content_type, "text/html; charset=utf-8");
+                response.body() = *ptrPage;
+            }
+        }
+    }
+    response.prepare_payload();
+
+    if (*ptrFault == EReplayFault::TRUNCATE)
+    {
+        // header still tells the whole size
+        response.body().resize(response.body().size() / 2);
+    }
+    return response;
+}
+
+std::size_t CReplayServer::getChunkSize(const CReplayProfile& profile)
+{
+    std::chrono::duration<double> writeInterval = WRITE_INTERVAL;
+    double bandwidthKbPerSecond = profile.getBandwidthKbPerSecond();
+    return (bandwidthKbPerSecond > 0.0)
+        ? std::max(MIN_CHUNK_SIZE, static_cast<std::size_t>(bandwidthKbPerSecond * 1024 * writeInterval.count()))
+        : 0;
+}
+
+CReplayServer::Clock::duration CReplayServer::throttle(std::string_view host, const CReplayProfile& profile)
+{
+    if (profile.getRequestsPerSecond() <= 0.0)
+    {
+        return Clock::duration::zero();
+    }
+    auto it = _tokenBuckets.find(host);
+    if (it == _tokenBuckets.end())
+    {
+        it = _tokenBuckets.emplace(host, CTokenBucket(profile.getRequestsPerSecond(), profile.getBurst())).first;
+    }
+    Clock::time_point now = Clock::now();
+    if (it->second.tryConsume(now))
+    {
+        return Clock::duration::zero();
+    }
+    return std::max<Clock::duration>(it->second.getWaitTime(now), std::chrono::milliseconds(1));
+}
+
+EReplayFault CReplayServer::pickFault(const CReplayProfile& profile)
+{
+    if ((profile.getErrorRate() <= 0.0) || (std::uniform_real_distribution<double>(0.0, 1.0)(_random) >= profile.getErrorRate()))
+    {
+        return EReplayFault::NONE;
+    }
+    auto fault = static_cast<EReplayFault>(std::uniform_int_distribution<int>(
+        static_cast<int>(EReplayFault::SERVER_ERROR), static_cast<int>(EReplayFault::TRUNCATE))(_random));
+    ++_statistics.numFaults[fault];
+    return fault;
+}
+
+CReplayServer::Clock::duration CReplayServer::pickLatency(const CReplayProfile& profile)
+{
+    int latencyMs = profile.getLatencyMs();
+    if (profile.getJitterMs() > 0)
+    {
+        latencyMs += std::uniform_int_distribution<int>(0, profile.getJitterMs())(_random);
+    }
+    return std::chrono::milliseconds(latencyMs);
+}
+
+void CReplayServer::printStatistics(std::ostream& stream) const
+{
+    std::chrono::duration<double> elapsed = Clock::now() - _startTime;
+    stream << "Requests: " << _statistics.numRequests
+        << ", not found: " << _statistics.numNotFound
+        << ", throttled: " << _statistics.numThrottled << std::endl;
+    for (const auto& [fault, numFaults] : _statistics.numFaults)
+    {
+        stream << "Fault " << getReplayFault(fault) << ": " << numFaults << std::endl;
+    }
+    if (elapsed.count() > 0.0)
+    {
+        stream << "Throughput: " << _statistics.responseTimes.size() / elapsed.count() << " responses/s, "
+            << _statistics.numBytesSent / 1024.0 / elapsed.count() << " KB/s" << std::endl;
+    }
+
+    std::vector<Clock::duration> responseTimes = _statistics.responseTimes;
+    if (!responseTimes.empty())
+    {
+        std::sort(responseTimes.begin(), responseTimes.end());
+        stream << "Response time, ms:";
+        for (int percentile : {50, 90, 99})
+        {
+            std::size_t index = std::min(responseTimes.size() - 1, responseTimes.size() * percentile / 100);
+            std::chrono::duration<double, std::milli> responseTime = responseTimes[index];
+            stream << " p" << percentile << " " << responseTime.count();
+        }
+        std::chrono::duration<double, std::milli> maxResponseTime = responseTimes.back();
+        stream << " max " << maxResponseTime.count() << std::endl;
+    }
+}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/beast/core/tcp_stream.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/string_body.hpp>
+#include <boost/beast/ssl/ssl_stream.hpp>
+#include <map>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <ostream>
+#include <cstdint>
+#include "token_bucket.h"
+#include "replay_corpus.h"
+#include "replay_profile.h"
+
+namespace watchList
+{
+    enum class EReplayFault
+    {
+        NONE = 0,
+        // 500 response
+        SERVER_ERROR,
+        // 503 response with Retry-After
+        UNAVAILABLE,
+        // connection is closed instead of response
+        RESET,
+        // connection is closed in the middle of the body
+        TRUNCATE
+    };
+
+    std::string_view getReplayFault(EReplayFault fault);
+
+    // Serves pages of replay corpus over HTTPS/1.1 or HTTP/2, as ALPN chooses, in place of the real hosts, so downloads
+    // can be benchmarked without network. Host of the page is taken from Host header, its replay profile sets latency, bandwidth,
+    // failures and rate limit of responses. Faults are picked by random generator with given seed, so runs repeat.
+    // Must be run by one io context thread.
+    class CReplayServer
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+    public:
+        CReplayServer(boost::asio::io_context& ioContext, boost::asio::ssl::context& sslContext, unsigned short port,
+            const CReplayCorpus& corpus, const CReplayProfiles& profiles, unsigned int seed = 1);
+
+    public:
+        void start();
+
+        // requests, throughput and percentiles of response time
+        void printStatistics(std::ostream& stream) const;
+
+    private:
+        class CSession;
+        class CHttp2Session;
+
+        typedef boost::beast::ssl_stream<boost::beast::tcp_stream> SslStream;
+        typedef boost::beast::http::response<boost::beast::http::string_body> Response;
+
+        struct Statistics
+        {
+            int numRequests = 0;
+            int numNotFound = 0;
+            int numThrottled = 0;
+            std::map<EReplayFault, int> numFaults;
+            std::uint64_t numBytesSent = 0;
+            // from received request to the last byte of response
+            std::vector<Clock::duration> responseTimes;
+        };
+
+        typedef std::map<std::string, CTokenBucket, std::less<>> TokenBuckets;
+
+    private:
+        // bandwidth is limited by writing one chunk per interval
+        static std::chrono::milliseconds WRITE_INTERVAL;
+        static std::size_t MIN_CHUNK_SIZE;
+
+    private:
+        void accept();
+        // Response of recorded page, of rate limit or of picked fault, which is returned in fault.
+        // Reset and truncate faults are carried out by session.
+        Response createResponse(std::string_view host, std::string_view target, unsigned int version, const CReplayProfile& profile,
+            EReplayFault* ptrFault);
+        // zero if bandwidth isn't limited
+        static std::size_t getChunkSize(const CReplayProfile& profile);
+        // zero if request is within rate limit of host, time to wait otherwise
+        Clock::duration throttle(std::string_view host, const CReplayProfile& profile);
+        EReplayFault pickFault(const CReplayProfile& profile);
+        Clock::duration pickLatency(const CReplayProfile& profile);
+
+    private:
+        boost::asio::io_context& _ioContext;
+        boost::asio::ssl::context& _sslContext;
+        boost::asio::ip::tcp::acceptor _acceptor;
+        const CReplayCorpus& _corpus;
+        const CReplayProfiles& _profiles;
+        std::mt19937 _random;
+        TokenBuckets _tokenBuckets;
+        Clock::time_point _startTime;
+        Statistics _statistics;
+    };
+}
@@ -0,0 +1,138 @@
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <iostream>
+#include <stdexcept>
+#include "replay_corpus.h"
+#include "replay_profile.h"
+#include "replay_server.h"
+
+using namespace watchList;
+using namespace boost;
+
+// Stand-in HTTPS server for downloader benchmarks, serves recorded pages without network.
+// Downloader is pointed to it with --replay <address:port>, pages are recorded with --record <dir>.
+
+static void printUsage()
+{
+    std::cerr << "Usage: japanwatchlist_replay_server <corpus dir> [--port <port>] [--profiles <file>] "
+        "[--cert <pem file> --key <pem file>] [--seed <number>]" << std::endl;
+}
+
+// certificate isn't verified by downloader, so the server doesn't need a real one
+static void useSelfSignedCertificate(asio::ssl::context& sslContext)
+{
+    EVP_PKEY* ptrKey = EVP_EC_gen("P-256");
+    X509* ptrCertificate = X509_new();
+    if ((ptrKey == nullptr) || (ptrCertificate == nullptr))
+    {
+        throw std::runtime_error("Cannot create certificate");
+    }
+    X509_set_version(ptrCertificate, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(ptrCertificate), 1);
+    X509_gmtime_adj(X509_getm_notBefore(ptrCertificate), 0);
+    X509_gmtime_adj(X509_getm_notAfter(ptrCertificate), 365L * 24 * 60 * 60);
+    X509_set_pubkey(ptrCertificate, ptrKey);
+
+    X509_NAME* ptrName = X509_get_subject_name(ptrCertificate);
+    X509_NAME_add_entry_by_txt(ptrName, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(ptrCertificate, ptrName);
+    X509_sign(ptrCertificate, ptrKey, EVP_sha256());
+
+    // context takes its own references
+    SSL_CTX_use_certificate(sslContext.native_handle(), ptrCertificate);
+    SSL_CTX_use_PrivateKey(sslContext.native_handle(), ptrKey);
+    X509_free(ptrCertificate);
+    EVP_PKEY_free(ptrKey);
+}
+
+int main(int argCount, char** argValues)
+{
+    if ((argCount < 2) || (argValues[1][0] == '-'))
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::string corpusDirPath = argValues[1];
+    unsigned short port = 8443;
+    unsigned int seed = 1;
+    std::string profilesFilePath;
+    std::string certificateFilePath;
+    std::string keyFilePath;
+
+    try
+    {
+        for (int argNum = 2; argNum + 1 < argCount; argNum += 2)
+        {
+            std::string_view argValue = argValues[argNum];
+            if (argValue == "--port")
+            {
+                port = static_cast<unsigned short>(std::stoi(argValues[argNum + 1]));
+            }
+            else if (argValue == "--profiles")
+            {
+                profilesFilePath = argValues[argNum + 1];
+            }
+            else if (argValue == "--cert")
+            {
+                certificateFilePath = argValues[argNum + 1];
+            }
+            else if (argValue == "--key")
+            {
+                keyFilePath = argValues[argNum + 1];
+            }
+            else if (argValue == "--seed")
+            {
+                seed = static_cast<unsigned int>(std::stoul(argValues[argNum + 1]));
+            }
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+
+        CReplayCorpus corpus(corpusDirPath);
+        corpus.load();
+        CReplayProfiles profiles;
+        if (!profilesFilePath.empty())
+        {
+            profiles.load(profilesFilePath);
+        }
+
+        asio::ssl::context sslContext(asio::ssl::context::tlsv12_server);
+        if (certificateFilePath.empty() || keyFilePath.empty())
+        {
+            useSelfSignedCertificate(sslContext);
+        }
+        else
+        {
+            sslContext.use_certificate_chain_file(certificateFilePath);
+            sslContext.use_private_key_file(keyFilePath, asio::ssl::context::pem);
+        }
+
+        asio::io_context ioContext;
+        CReplayServer server(ioContext, sslContext, port, corpus, profiles, seed);
+        server.start();
+
+        asio::signal_set signals(ioContext, SIGINT, SIGTERM);
+        signals.async_wait(
+            [&ioContext, &server](const system::error_code&, int)
+            {
+                server.printStatistics(std::cout);
+                ioContext.stop();
+            });
+
+        std::cout << "Serving " << corpus.getNumPages() << " pages on port " << port << std::endl;
+        ioContext.run();
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
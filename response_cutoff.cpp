@@ -0,0 +1,38 @@
+#include "response_cutoff.h"
+
+namespace watchList
+{
+CResponseCutoff::CResponseCutoff(std::string_view endMarker, std::size_t maxSize)
+    : _endMarker(endMarker)
+    , _maxSize(maxSize)
+{
+}
+
+void CResponseCutoff::limitSize(std::size_t maxSize)
+{
+    if ((maxSize != 0) && ((_maxSize == 0) || (maxSize < _maxSize)))
+    {
+        _maxSize = maxSize;
+    }
+}
+
+std::size_t CResponseCutoff::findEnd(std::string_view content, std::size_t checkedSize) const
+{
+    if (!_endMarker.empty())
+    {
+        // marker may be split between the checked part and the new one
+        std::size_t searchPos = (checkedSize < _endMarker.size()) ? 0 : checkedSize - _endMarker.size() + 1;
+        std::size_t markerPos = content.find(_endMarker, searchPos);
+        if (markerPos != std::string::npos)
+        {
+            std::size_t end = markerPos + _endMarker.size();
+            return ((_maxSize != 0) && (end > _maxSize)) ? _maxSize : end;
+        }
+    }
+    if ((_maxSize != 0) && (content.size() >= _maxSize))
+    {
+        return _maxSize;
+    }
+    return std::string::npos;
+}
+}
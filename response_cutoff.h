@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace watchList
+{
+    // Tells when the received beginning of the page is enough for its parser, so the rest isn't downloaded.
+    // Page ends after end marker or at max size, zero max size means no limit.
+    class CResponseCutoff
+    {
+    public:
+        CResponseCutoff(std::string_view endMarker = std::string_view(), std::size_t maxSize = 0);
+
+    public:
+        bool isEnabled() const
+            { return !_endMarker.empty() || (_maxSize != 0); }
+
+        const std::string& getEndMarker() const
+            { return _endMarker; }
+
+        std::size_t getMaxSize() const
+            { return _maxSize; }
+
+        // keeps the smaller of two limits
+        void limitSize(std::size_t maxSize);
+
+        // Size of the needed part of content, npos if more content is needed.
+        // Content before checkedSize has been searched already, so growing content is checked chunk by chunk.
+        std::size_t findEnd(std::string_view content, std::size_t checkedSize = 0) const;
+
+    private:
+        std::string _endMarker;
+        std::size_t _maxSize;
+    };
+}
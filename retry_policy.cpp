@@ -0,0 +1,42 @@
+#include <algorithm>
+#include <cmath>
+#include "retry_policy.h"
+
+namespace watchList
+{
+int CRetryPolicy::THROTTLED_DELAY_FACTOR = 4;
+
+CRetryPolicy::CRetryPolicy()
+    : _randomEngine(std::random_device()())
+{
+    setSettings(CDownloaderSettings());
+}
+
+void CRetryPolicy::setSettings(const CDownloaderSettings& settings)
+{
+    _maxAttempts = settings.getMaxAttempts();
+    _retryDelayMs = std::max(settings.getRetryDelayMs(), 0);
+    _maxRetryDelayMs = std::max(settings.getMaxRetryDelayMs(), _retryDelayMs);
+}
+
+bool CRetryPolicy::isRetryAllowed(EDownloadFailure failure, int numAttempts) const
+{
+    bool isRetryableFailure = (failure != EDownloadFailure::NONE) && (failure != EDownloadFailure::HARD);
+    return isRetryableFailure && (numAttempts < _maxAttempts);
+}
+
+CRetryPolicy::Clock::duration CRetryPolicy::getRetryDelay(EDownloadFailure failure, int numAttempts)
+{
+    // throttled server needs more time to recover than the one which dropped connection
+    double delayMs = _retryDelayMs * std::pow(2.0, std::max(numAttempts - 1, 0));
+    if (failure == EDownloadFailure::THROTTLED)
+    {
+        delayMs *= THROTTLED_DELAY_FACTOR;
+    }
+    delayMs = std::min(delayMs, static_cast<double>(_maxRetryDelayMs));
+
+    // half of the delay is kept, so retry never comes back immediately
+    std::uniform_real_distribution<double> jitter(delayMs / 2.0, delayMs);
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(jitter(_randomEngine)));
+}
+}
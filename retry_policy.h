@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <random>
+#include "download_backend.h"
+#include "downloader_settings.h"
+
+namespace watchList
+{
+    // Decides whether failed download is repeated and how long it waits before the next attempt
+    class CRetryPolicy
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+    public:
+        CRetryPolicy();
+
+    public:
+        void setSettings(const CDownloaderSettings& settings);
+
+        bool isRetryAllowed(EDownloadFailure failure, int numAttempts) const;
+
+        // exponential backoff with random jitter, so retries of many tasks don't come to server at once
+        Clock::duration getRetryDelay(EDownloadFailure failure, int numAttempts);
+
+    private:
+        static int THROTTLED_DELAY_FACTOR;
+
+    private:
+        int _maxAttempts;
+        int _retryDelayMs;
+        int _maxRetryDelayMs;
+        std::mt19937 _randomEngine;
+    };
+}
@@ -0,0 +1,79 @@
+#include <pthread.h>
+#include <cstdlib>
+#include <iostream>
+#include "shutdown_signal.h"
+
+namespace watchList
+{
+CShutdownSignal::CShutdownSignal()
+    : _isRequested(false)
+    , _isStopping(false)
+{
+    sigemptyset(&_signals);
+    sigaddset(&_signals, SIGINT);
+    sigaddset(&_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &_signals, nullptr);
+    _thread = std::thread([this]() { waitSignal(); });
+}
+
+CShutdownSignal::~CShutdownSignal()
+{
+    {
+        std::unique_lock lock(_mutex);
+        _isStopping = true;
+    }
+    // wakes up the waiting thread, signal is blocked for the rest of process
+    pthread_kill(_thread.native_handle(), SIGTERM);
+    _thread.join();
+}
+
+void CShutdownSignal::waitSignal()
+{
+    int signalNumber = 0;
+    sigwait(&_signals, &signalNumber);
+    {
+        std::unique_lock lock(_mutex);
+        if (_isStopping)
+        {
+            return;
+        }
+        _isRequested = true;
+    }
+    _condition.notify_all();
+    _cancellationToken.cancel();
+
+    // cancelled work may still hang, e.g. in report rendering
+    sigwait(&_signals, &signalNumber);
+    {
+        std::unique_lock lock(_mutex);
+        if (_isStopping)
+        {
+            return;
+        }
+    }
+    std::cerr << "Stopped by the second signal" << std::endl;
+    std::_Exit(EXIT_FAILURE);
+}
+
+bool CShutdownSignal::isRequested() const
+{
+    std::unique_lock lock(_mutex);
+    return _isRequested;
+}
+
+bool CShutdownSignal::waitUntil(Clock::time_point time, std::function<bool()> condition)
+{
+    std::unique_lock lock(_mutex);
+    _condition.wait_until(lock, time, [this, &condition]() { return _isRequested || (condition && condition()); });
+    return !_isRequested;
+}
+
+void CShutdownSignal::wakeUp()
+{
+    {
+        // waiting thread either checks the changed condition yet or already waits for notification
+        std::unique_lock lock(_mutex);
+    }
+    _condition.notify_all();
+}
+}
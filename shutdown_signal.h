@@ -0,0 +1,51 @@
+#pragma once
+
+#include <csignal>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include "cancellation_token.h"
+
+namespace watchList
+{
+    // Takes SIGINT and SIGTERM on its own thread, so long running loops finish their current work and stop.
+    // Downloads of current work are cancelled through the token, the second signal exits at once.
+    // Must be created before other threads, they inherit signal mask which leaves the signals to it.
+    class CShutdownSignal
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+    public:
+        CShutdownSignal();
+        ~CShutdownSignal();
+
+        CShutdownSignal(const CShutdownSignal&) = delete;
+        CShutdownSignal& operator=(const CShutdownSignal&) = delete;
+
+    public:
+        bool isRequested() const;
+        // cancelled when shutdown is requested
+        const CCancellationToken& getCancellationToken() const
+            { return _cancellationToken; }
+
+        // False if shutdown is requested before the time comes. Wait also ends when wakeUp is called
+        // and condition is true, condition is checked under lock, so wakeUp right after it is changed isn't lost.
+        bool waitUntil(Clock::time_point time, std::function<bool()> condition = nullptr);
+        void wakeUp();
+
+    private:
+        void waitSignal();
+
+    private:
+        sigset_t _signals;
+        mutable std::mutex _mutex;
+        std::condition_variable _condition;
+        bool _isRequested;
+        bool _isStopping;
+        CCancellationToken _cancellationToken;
+        std::thread _thread;
+    };
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <list>
+#include <atomic>
+
+namespace watchList
+{
+    // Lock-free queue with many producers and one consumer.
+    // Producers push single items, consumer takes all of them at once in order of push.
+    template <class T>
+    class CSubmissionQueue
+    {
+    public:
+        typedef std::list<T> List;
+
+    public:
+        CSubmissionQueue()
+            : _head(nullptr)
+            {}
+
+        ~CSubmissionQueue()
+            { popAll(); }
+
+        CSubmissionQueue(const CSubmissionQueue&) = delete;
+        CSubmissionQueue& operator=(const CSubmissionQueue&) = delete;
+
+    public:
+        // true if queue was empty, so consumer has to be woken up
+        bool push(T&& item);
+
+        List popAll();
+
+    private:
+        struct Node
+        {
+            T item;
+            Node* next;
+        };
+
+    private:
+        std::atomic<Node*> _head;
+    };
+
+    template <class T>
+    bool CSubmissionQueue<T>::push(T&& item)
+    {
+        // node can't be touched after it is published, consumer may already delete it
+        Node* head = _head.load(std::memory_order_relaxed);
+        Node* node = new Node{ std::move(item), head };
+        while (!_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed))
+        {
+            node->next = head;
+        }
+        return head == nullptr;
+    }
+
+    template <class T>
+    typename CSubmissionQueue<T>::List CSubmissionQueue<T>::popAll()
+    {
+        // nodes are linked from the last pushed one
+        List items;
+        Node* node = _head.exchange(nullptr, std::memory_order_acquire);
+        while (node != nullptr)
+        {
+            items.push_front(std::move(node->item));
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+        return items;
+    }
+}
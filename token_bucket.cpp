@@ -0,0 +1,56 @@
+#include <algorithm>
+#include "token_bucket.h"
+
+namespace watchList
+{
+CTokenBucket::CTokenBucket(double tokensPerSecond, double capacity)
+    : _tokensPerSecond(tokensPerSecond)
+    , _capacity(std::max(capacity, 1.0))
+    , _tokens(1.0)
+    , _lastRefillTime(Clock::now())
+{
+}
+
+void CTokenBucket::refill(Clock::time_point now)
+{
+    if (now > _lastRefillTime)
+    {
+        std::chrono::duration<double> elapsed = now - _lastRefillTime;
+        _tokens = std::min(_capacity, _tokens + elapsed.count() * _tokensPerSecond);
+        _lastRefillTime = now;
+    }
+}
+
+bool CTokenBucket::tryConsume(Clock::time_point now)
+{
+    refill(now);
+    if (_tokensPerSecond <= 0.0)
+    {
+        // not limited
+        return true;
+    }
+    if (_tokens >= 1.0)
+    {
+        _tokens -= 1.0;
+        return true;
+    }
+    return false;
+}
+
+CTokenBucket::Clock::duration CTokenBucket::getWaitTime(Clock::time_point now)
+{
+    refill(now);
+    if ((_tokens >= 1.0) || (_tokensPerSecond <= 0.0))
+    {
+        return Clock::duration::zero();
+    }
+    std::chrono::duration<double> waitTime((1.0 - _tokens) / _tokensPerSecond);
+    return std::chrono::ceil<Clock::duration>(waitTime);
+}
+
+void CTokenBucket::setRate(double tokensPerSecond, Clock::time_point now)
+{
+    refill(now);
+    _tokensPerSecond = tokensPerSecond;
+}
+}
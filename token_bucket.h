@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+
+namespace watchList
+{
+    class CTokenBucket
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+    public:
+        CTokenBucket(double tokensPerSecond, double capacity);
+
+    public:
+        bool tryConsume(Clock::time_point now);
+
+        // zero if token is available at the moment
+        Clock::duration getWaitTime(Clock::time_point now);
+
+        double getRate() const
+            { return _tokensPerSecond; }
+
+        void setRate(double tokensPerSecond, Clock::time_point now);
+
+    private:
+        void refill(Clock::time_point now);
+
+    private:
+        double _tokensPerSecond;
+        double _capacity;
+        double _tokens;
+        Clock::time_point _lastRefillTime;
+    };
+}
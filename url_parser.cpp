@@ -0,0 +1,32 @@
+#include "url_parser.h"
+
+namespace watchList
+{
+CUrlParser::CUrlParser(std::string_view url)
+{
+    std::size_t protocolEndPos = url.find("://");
+    if (protocolEndPos != std::string::npos)
+    {
+        _protocol = url.substr(0, protocolEndPos);
+        url.remove_prefix(protocolEndPos + 3);
+    }
+
+    std::size_t targetPos = url.find('/');
+    std::string_view authority = url.substr(0, targetPos);
+    _target = (targetPos == std::string::npos) ? "/" : url.substr(targetPos);
+
+    std::size_t portPos = authority.find(':');
+    _host = authority.substr(0, portPos);
+    _port = (portPos == std::string::npos) ? getDefaultPort(_protocol) : authority.substr(portPos + 1);
+}
+
+bool CUrlParser::isSecure() const
+{
+    return _protocol == "https";
+}
+
+std::string_view CUrlParser::getDefaultPort(std::string_view protocol)
+{
+    return (protocol == "https") ? "443" : "80";
+}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+namespace watchList
+{
+    class CUrlParser
+    {
+    public:
+        CUrlParser(std::string_view url);
+
+    public:
+        const std::string& getProtocol() const
+            { return _protocol; }
+
+        const std::string& getHost() const
+            { return _host; }
+
+        const std::string& getPort() const
+            { return _port; }
+
+        const std::string& getTarget() const
+            { return _target; }
+
+        bool isSecure() const;
+
+    private:
+        static std::string_view getDefaultPort(std::string_view protocol);
+
+    private:
+        std::string _protocol;
+        std::string _host;
+        std::string _port;
+        std::string _target;
+    };
+}
@@ -1,9 +1,17 @@
-#include <gtk/gtk.h>
-#include <webkit/webkit.h>
+#include <glib.h>
 #include <list>
-#include <map>
-#include <random>
+#include <algorithm>
+#include <set>
+#include <tuple>
+#include <atomic>
+#include <iostream>
 #include <filesystem>
+#include "url_parser.h"
+#include "retry_policy.h"
+#include "download_scheduler.h"
+#include "submission_queue.h"
+#include "https_download_backend.h"
+#include "webkit_download_backend.h"
 #include "web_engine_downloader.h"
 
 namespace watchList
@@ -13,266 +21,598 @@ class CWebEngineDownloader::CImpl
 public:
     CImpl();
     ~CImpl();
-    
+
     static std::shared_ptr<CImpl> create();
-    
+
 public:
-    FutureResponseType addDownload(std::string_view link, std::string_view responseName);
+    // future is kept by task when handler is given, returned one is empty then
+    FutureResponseType addDownload(std::string_view link, std::string_view responseName, int priority, TimePoint deadline,
+        const CCancellationToken& cancellationToken, const CResponseCutoff& cutoff, CompletionHandler handler = nullptr);
     void start();
-    void setDownloadDir(std::string_view dir);    
-
-private:
-    void setDownloadDestination(WebKitDownload* download, std::string_view fileName);
-    void startTask();
-    void processTask();
-    bool hasTask();
-    void waitForTask();
-    void completeTask(WebKitDownload* download, GError* error = nullptr);    
-    void startDownloading(GtkApplication* app);
-    
-    int getNumStepsBeforeHugeBreak();
-    int getSmallBreakTime();
-    int getHugeBreakTime();
+    void setDownloadDir(std::string_view dir);
+    void setSettings(const CDownloaderSettings& settings);
 
-private:
-    static void processTask(gpointer userData);
-    static gboolean waitForTask(gpointer userData);
-    static void onActivateApp(GtkApplication* app, gpointer userData);
-    static gboolean onDecideDestination(WebKitDownload* download, gchar* suggestedFilename, gpointer userData);    
-    static void onDownloadFinished(WebKitDownload* download, gpointer userData);
-    static void onDownloadFailed(WebKitDownload* download, GError* error, gpointer userData);
-    
 private:
     struct DownloadTask
     {
         typedef std::list<DownloadTask> List;
-        
-        DownloadTask(std::string_view link, std::string_view responseName);
-        
+
+        DownloadTask(std::string_view link, std::string_view responseName, int priority, TimePoint deadline,
+            const CCancellationToken& cancellationToken, const CResponseCutoff& cutoff);
+
         std::string link;
+        std::string host;
         std::string responseName;
         std::string targetResponsePath;
-        std::promise<std::string> responsePath;
+        int priority;
+        TimePoint deadline;
+        // tasks of the same priority and deadline are started in order of adding
+        std::uint64_t sequenceNumber;
+        bool isInProcess;
+        bool isFallback;
+        int numAttempts;
+        CCancellationToken cancellationToken;
+        bool isCancelled;
+        // every attempt is cancelled on its own when it exceeds total timeout
+        CCancellationToken attemptCancellationToken;
+        guint timeoutSourceId;
+        bool isTimedOut;
+        CDownloadScheduler::Clock::time_point startTime;
+        // task isn't started again before this time after failed attempt
+        CDownloadScheduler::Clock::time_point retryTime;
+        CResponseCutoff cutoff;
+        std::promise<ResponseType> response;
+        CompletionHandler handler;
+        FutureResponseType handlerResponse;
+    };
+
+    struct DownloadCompletion
+    {
+        CImpl* ptrThis;
+        DownloadTask::List::iterator taskIt;
+        CDownloadResult result;
+    };
+
+    struct DownloadCancellation
+    {
+        CImpl* ptrThis;
+        std::uint64_t sequenceNumber;
     };
-    
-    typedef std::map<WebKitDownload*, DownloadTask::List::iterator> DownloadTasksInProcess;
-    
+
+    struct DownloadTaskOrder
+    {
+        bool operator()(DownloadTask::List::iterator first, DownloadTask::List::iterator second) const;
+    };
+
+    // tasks waiting to start, ordered from the most urgent one
+    typedef std::set<DownloadTask::List::iterator, DownloadTaskOrder> DownloadTaskQueue;
+    typedef CDownloadScheduler::Clock Clock;
+
+private:
+    void startWorkers();
+    void startTask(Clock::duration waitTime = Clock::duration::zero());
+    void processTask();
+    void downloadTask(DownloadTask::List::iterator taskIt, CDownloadBackend& backend);
+    void takeSubmittedTasks();
+    void preconnect(const DownloadTask& task);
+    void completeTask(DownloadTask::List::iterator taskIt, CDownloadResult&& result);
+    void retryTask(DownloadTask::List::iterator taskIt, const CDownloadResult& result);
+    void failTask(DownloadTask::List::iterator taskIt, const CDownloadResult& result);
+    void finishTask(DownloadTask::List::iterator taskIt);
+    // must follow every value or exception set to response
+    void notifyCompletion(DownloadTask& task);
+    void cancelTask(std::uint64_t sequenceNumber);
+    void subscribeCancellation(const DownloadTask& task);
+    void stopWorker();
+    DownloadTask::List::iterator findNextTask(Clock::time_point now);
+    bool getWaitTime(Clock::time_point now, Clock::duration* waitTime);
+    void checkSchedulerSettings();
+    bool isFallbackAllowed(const DownloadTask& task);
+    CDownloaderSettings getSettings();
+    std::string createTargetResponsePath(const DownloadTask& task);
+
+    CDownloadBackend& getBackend(const DownloadTask& task);
+    CDownloadBackend& getHttpsBackend();
+    CDownloadBackend& getWebKitBackend();
+
+private:
+    static void processTask(gpointer userData);
+    static void onTasksSubmitted(gpointer userData);
+    static void onQuit(gpointer userData);
+    static gboolean onDownloadCompleted(gpointer userData);
+    static gboolean onDownloadCancelled(gpointer userData);
+    static void onDownloadTimeout(gpointer userData);
+
 private:
-    std::default_random_engine _randomEngine;
-    std::uniform_int_distribution<int> _smallBreakDist;
-    std::uniform_int_distribution<int> _hugeBreakDist;
-    std::uniform_int_distribution<int> _numStepsUntilHugeBreakDist;
-    
     std::string _downloadDir;
-    GtkApplication* _app;
-    GtkWidget* _webView;
+    CDownloaderSettings _settings;
+    std::atomic<bool> _isSettingsChanged;
+    // backends are created on demand and used only from main loop thread
+    std::unique_ptr<CHttpsDownloadBackend> _httpsBackend;
+    std::unique_ptr<CWebKitDownloadBackend> _webKitBackend;
+    GMainLoop* _mainLoop;
+    // tasks are added from any thread, task list is handled only from main loop
+    CSubmissionQueue<DownloadTask> _submittedTasks;
     DownloadTask::List _tasks;
-    DownloadTask::List::iterator _nextTask;
-    DownloadTasksInProcess _tasksInProcess;
-    int _numStepsUntilHugeBreak;
+    DownloadTaskQueue _taskQueue;
+    std::uint64_t _numTasksAdded;
+    std::set<std::string> _preconnectedHosts;
+    CDownloadScheduler _scheduler;
+    CRetryPolicy _retryPolicy;
+    // worker is active while it waits for a host budget or downloads a task
+    int _numActiveWorkers;
 
-    std::mutex _tasksMutex;
     std::mutex _downloadDirMutex;
-    std::thread _thread;    
+    std::mutex _settingsMutex;
+    std::thread _thread;
 };
 
-CWebEngineDownloader::CImpl::DownloadTask::DownloadTask(std::string_view link, std::string_view responseName)
+CWebEngineDownloader::CImpl::DownloadTask::DownloadTask(std::string_view link, std::string_view responseName, int priority, TimePoint deadline,
+    const CCancellationToken& cancellationToken, const CResponseCutoff& cutoff)
     : link(link)
+    , host(CUrlParser(link).getHost())
     , responseName(responseName)
+    , priority(priority)
+    , deadline(deadline)
+    , sequenceNumber(0)
+    , isInProcess(false)
+    , isFallback(false)
+    , numAttempts(0)
+    , cancellationToken(cancellationToken)
+    , isCancelled(false)
+    , timeoutSourceId(0)
+    , isTimedOut(false)
+    , cutoff(cutoff)
 {
 }
 
 CWebEngineDownloader::CImpl::CImpl()
-    : _smallBreakDist(200, 400)
-    , _hugeBreakDist(3000, 5000)
-    , _numStepsUntilHugeBreakDist(10, 50)
-    , _app(nullptr)
-    , _webView(nullptr)
-    , _nextTask(_tasks.end())
-    , _numStepsUntilHugeBreak(0)
+    : _isSettingsChanged(true)
+    , _mainLoop(g_main_loop_new(nullptr, false))
+    , _numTasksAdded(0)
+    , _numActiveWorkers(0)
 {
     _thread = std::thread([this]() { start(); });
 }
 
 CWebEngineDownloader::CImpl::~CImpl()
 {
-    _thread.detach();
+    // loop thread may not run the loop yet, quit waits in its context until it does
+    g_idle_add_once(onQuit, this);
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+    g_main_loop_unref(_mainLoop);
+}
+
+bool CWebEngineDownloader::CImpl::DownloadTaskOrder::operator()(DownloadTask::List::iterator first, DownloadTask::List::iterator second) const
+{
+    // retried tasks go behind fresh ones, so failing pages don't hold up the rest
+    auto getOrder = [](const DownloadTask& task)
+        {
+            return std::make_tuple(task.numAttempts > 0, -task.priority, task.deadline, task.sequenceNumber);
+        };
+    return getOrder(*first) < getOrder(*second);
 }
 
-CWebEngineDownloader::FutureResponseType CWebEngineDownloader::CImpl::addDownload(std::string_view link, std::string_view responseName)
+CWebEngineDownloader::FutureResponseType CWebEngineDownloader::CImpl::addDownload(std::string_view link, std::string_view responseName, int priority, TimePoint deadline,
+    const CCancellationToken& cancellationToken, const CResponseCutoff& cutoff, CompletionHandler handler)
 {
-    std::unique_lock lock(_tasksMutex);
-    _tasks.emplace(_tasks.end(), link, responseName);
-    return _tasks.back().responsePath.get_future();
+    DownloadTask task(link, responseName, priority, deadline, cancellationToken, cutoff);
+    FutureResponseType response = task.response.get_future();
+    if (handler)
+    {
+        task.handler = std::move(handler);
+        task.handlerResponse = std::move(response);
+    }
+    if (_submittedTasks.push(std::move(task)))
+    {
+        // idle source wakes up main context, later tasks are taken together with this one
+        g_idle_add_once(onTasksSubmitted, this);
+    }
+    return response;
 }
 
 void CWebEngineDownloader::CImpl::start()
 {
-    _app = gtk_application_new("org.gtk.example", G_APPLICATION_DEFAULT_FLAGS);
-    g_signal_connect(_app, "activate", G_CALLBACK(onActivateApp), this);  
-    g_application_run(G_APPLICATION(_app), 0, nullptr);
-    g_clear_object(&_app);
+    g_main_loop_run(_mainLoop);
+    _webKitBackend.reset();
+    _httpsBackend.reset();
 }
 
-int CWebEngineDownloader::CImpl::getNumStepsBeforeHugeBreak()
+void CWebEngineDownloader::CImpl::setDownloadDir(std::string_view dir)
 {
-    return _numStepsUntilHugeBreakDist(_randomEngine);
+    // gtk accepts only absolut path
+    std::unique_lock lock(_downloadDirMutex);
+    _downloadDir = std::filesystem::canonical(dir).string();
+    if (!_downloadDir.empty() && (_downloadDir.back() != '/'))
+    {
+        _downloadDir.push_back('/');
+    }
 }
 
-int CWebEngineDownloader::CImpl::getSmallBreakTime()
-{  
-    return _smallBreakDist(_randomEngine);
+void CWebEngineDownloader::CImpl::setSettings(const CDownloaderSettings& settings)
+{
+    std::unique_lock lock(_settingsMutex);
+    _settings = settings;
+    _isSettingsChanged = true;
 }
 
-int CWebEngineDownloader::CImpl::getHugeBreakTime()
+CDownloaderSettings CWebEngineDownloader::CImpl::getSettings()
 {
-    return _hugeBreakDist(_randomEngine);
+    std::unique_lock lock(_settingsMutex);
+    return _settings;
 }
 
-void CWebEngineDownloader::CImpl::setDownloadDestination(WebKitDownload* download, std::string_view fileName)
+std::string CWebEngineDownloader::CImpl::createTargetResponsePath(const DownloadTask& task)
 {
-    auto it = _tasksInProcess.find(download);
-    if (it != _tasksInProcess.end())
+    std::filesystem::path fileName(task.responseName);
+    if (fileName.empty())
     {
-        auto taskIt = it->second;
-        taskIt->targetResponsePath.clear();
+        const std::string& target = CUrlParser(task.link).getTarget();
+        fileName = std::filesystem::path(target.substr(0, target.find('?'))).filename();
+        if (fileName.empty())
         {
-            std::unique_lock lock(_downloadDirMutex);
-            taskIt->targetResponsePath.append(_downloadDir);
+            fileName = "index.html";
         }
-        taskIt->targetResponsePath.append(taskIt->responseName.empty() ? fileName : taskIt->responseName);
-        webkit_download_set_destination(download, taskIt->targetResponsePath.c_str());
     }
+
+    std::unique_lock lock(_downloadDirMutex);
+    return std::filesystem::absolute(std::filesystem::path(_downloadDir) / fileName).string();
 }
 
-void CWebEngineDownloader::CImpl::setDownloadDir(std::string_view dir)
+CDownloadBackend& CWebEngineDownloader::CImpl::getHttpsBackend()
 {
-    // gtk accepts only absolut path
-    std::unique_lock lock(_downloadDirMutex);
-    _downloadDir = std::filesystem::canonical(dir).string();
-    if (!_downloadDir.empty() && (_downloadDir.back() != '/'))
+    if (_httpsBackend == nullptr)
     {
-        _downloadDir.push_back('/');
+        _httpsBackend = std::make_unique<CHttpsDownloadBackend>(getSettings());
     }
+    return *_httpsBackend;
 }
 
-void CWebEngineDownloader::CImpl::startTask()
+CDownloadBackend& CWebEngineDownloader::CImpl::getWebKitBackend()
 {
-    if (_numStepsUntilHugeBreak <= 0)
+    if (_webKitBackend == nullptr)
     {
-        _numStepsUntilHugeBreak = getNumStepsBeforeHugeBreak();
-        g_timeout_add_once(getHugeBreakTime(), processTask, this);
+        _webKitBackend = std::make_unique<CWebKitDownloadBackend>(getSettings().getNumWorkers());
     }
-    else
+    return *_webKitBackend;
+}
+
+CDownloadBackend& CWebEngineDownloader::CImpl::getBackend(const DownloadTask& task)
+{
+    switch (getSettings().getBackend())
     {
-        g_timeout_add_once(getSmallBreakTime(), processTask, this);
+        case EDownloadBackend::HTTPS:
+            return getHttpsBackend();
+        case EDownloadBackend::WEB_KIT:
+            return getWebKitBackend();
+        case EDownloadBackend::AUTO:
+            break;
     }
+    CDownloadBackend& httpsBackend = getHttpsBackend();
+    return (task.isFallback || !httpsBackend.isSupported(task.link)) ? getWebKitBackend() : httpsBackend;
 }
 
-void CWebEngineDownloader::CImpl::processTask()
+bool CWebEngineDownloader::CImpl::isFallbackAllowed(const DownloadTask& task)
 {
-    WebKitDownload* download = webkit_web_view_download_uri(WEBKIT_WEB_VIEW(_webView), _nextTask->link.c_str());
-    g_signal_connect(download, "failed", G_CALLBACK(onDownloadFailed), this);
-    g_signal_connect(download, "finished", G_CALLBACK(onDownloadFinished), this);
-    if (!_downloadDir.empty())
+    return (getSettings().getBackend() == EDownloadBackend::AUTO) && !task.isFallback;
+}
+
+void CWebEngineDownloader::CImpl::startTask(Clock::duration waitTime)
+{
+    auto waitTimeMs = std::chrono::ceil<std::chrono::milliseconds>(waitTime);
+    g_timeout_add_once(waitTimeMs.count(), processTask, this);
+}
+
+void CWebEngineDownloader::CImpl::checkSchedulerSettings()
+{
+    if (_isSettingsChanged.exchange(false))
     {
-        g_signal_connect(download, "decide-destination", G_CALLBACK(onDecideDestination), this);
+        CDownloaderSettings settings = getSettings();
+        _scheduler.setSettings(settings);
+        _retryPolicy.setSettings(settings);
     }
+}
 
-    --_numStepsUntilHugeBreak;
-    _tasksInProcess[download] = _nextTask;
-    
-    bool hasOtherTasks = false;
+void CWebEngineDownloader::CImpl::downloadTask(DownloadTask::List::iterator taskIt, CDownloadBackend& backend)
+{
+    taskIt->attemptCancellationToken = CCancellationToken();
+    taskIt->isTimedOut = false;
+    CDownloaderSettings settings = getSettings();
+    auto timeout = settings.getTimeouts().getTotal();
+    taskIt->timeoutSourceId = g_timeout_add_once(timeout.count(), onDownloadTimeout, &*taskIt);
+
+    CResponseCutoff cutoff = taskIt->cutoff;
+    cutoff.limitSize(static_cast<std::size_t>(settings.getMaxPageSizeKb()) * 1024);
+    backend.download(taskIt->link, taskIt->targetResponsePath, cutoff,
+        [this, taskIt](CDownloadResult&& result)
+        {
+            // backends complete downloads on their own threads, task list is handled only from main loop
+            g_main_context_invoke(nullptr, onDownloadCompleted, new DownloadCompletion{ this, taskIt, std::move(result) });
+        },
+        taskIt->attemptCancellationToken);
+}
+
+void CWebEngineDownloader::CImpl::subscribeCancellation(const DownloadTask& task)
+{
+    // task can be completed and removed before cancellation reaches main loop, so it is found by sequence number
+    task.cancellationToken.subscribe(
+        [this, sequenceNumber = task.sequenceNumber]()
+        {
+            g_main_context_invoke(nullptr, onDownloadCancelled, new DownloadCancellation{ this, sequenceNumber });
+        });
+}
+
+void CWebEngineDownloader::CImpl::cancelTask(std::uint64_t sequenceNumber)
+{
+    auto taskIt = std::find_if(_tasks.begin(), _tasks.end(),
+        [sequenceNumber](const DownloadTask& task)
+        {
+            return task.sequenceNumber == sequenceNumber;
+        });
+    if ((taskIt == _tasks.end()) || taskIt->isCancelled)
     {
-        std::unique_lock lock(_tasksMutex);
-        hasOtherTasks = (++_nextTask != _tasks.end());
+        return;
     }
-    if (hasOtherTasks)
+
+    taskIt->isCancelled = true;
+    taskIt->response.set_exception(std::make_exception_ptr(std::runtime_error("Download of " + taskIt->link + " is cancelled")));
+    notifyCompletion(*taskIt);
+    if (taskIt->isInProcess)
+    {
+        // task is removed when backend completes it, it may happen right inside cancel
+        taskIt->attemptCancellationToken.cancel();
+    }
+    else
     {
-        startTask();    
+        _taskQueue.erase(taskIt);
+        _tasks.erase(taskIt);
     }
 }
 
-bool CWebEngineDownloader::CImpl::hasTask()
+CWebEngineDownloader::CImpl::DownloadTask::List::iterator CWebEngineDownloader::CImpl::findNextTask(Clock::time_point now)
 {
+    // the most urgent task whose host has budget is taken, so hosts interleave while others wait for their tokens
+    std::set<std::string> notReadyHosts;
+    for (auto queueIt = _taskQueue.begin(); queueIt != _taskQueue.end(); ++queueIt)
     {
-        std::unique_lock lock(_tasksMutex);
-        if (_tasks.empty())
+        DownloadTask::List::iterator taskIt = *queueIt;
+        if ((taskIt->retryTime <= now) && (notReadyHosts.count(taskIt->host) == 0))
         {
-            return false;
+            if (_scheduler.tryStartTask(taskIt->host, now))
+            {
+                _taskQueue.erase(queueIt);
+                return taskIt;
+            }
+            notReadyHosts.insert(taskIt->host);
         }
-        _nextTask = _tasks.begin();
     }
-    startTask();
-    return true;
+    return _tasks.end();
 }
 
-void CWebEngineDownloader::CImpl::waitForTask()
+bool CWebEngineDownloader::CImpl::getWaitTime(Clock::time_point now, Clock::duration* waitTime)
 {
-    g_timeout_add_seconds(5, waitForTask, this);
+    bool hasWaitTime = false;
+    for (DownloadTask::List::iterator taskIt : _taskQueue)
+    {
+        if (!_scheduler.isHostBusy(taskIt->host))
+        {
+            Clock::duration hostWaitTime = std::max(_scheduler.getWaitTime(taskIt->host, now), taskIt->retryTime - now);
+            if (!hasWaitTime || (hostWaitTime < *waitTime))
+            {
+                *waitTime = hostWaitTime;
+                hasWaitTime = true;
+            }
+        }
+    }
+    return hasWaitTime;
+}
+
+void CWebEngineDownloader::CImpl::startWorkers()
+{
+    int numWorkers = getSettings().getNumWorkers();
+    while (_numActiveWorkers < numWorkers)
+    {
+        ++_numActiveWorkers;
+        startTask();
+    }
+}
+
+void CWebEngineDownloader::CImpl::stopWorker()
+{
+    // worker is started again when a task is completed or submitted
+    --_numActiveWorkers;
 }
 
-void CWebEngineDownloader::CImpl::completeTask(WebKitDownload* download, GError* error)
+void CWebEngineDownloader::CImpl::processTask()
 {
-    auto it = _tasksInProcess.find(download);
-    if (it != _tasksInProcess.end())
+    checkSchedulerSettings();
+
+    Clock::time_point now = Clock::now();
+    auto taskIt = findNextTask(now);
+    if (taskIt == _tasks.end())
     {
-        auto taskIt = it->second;
-        if (error != nullptr)
+        Clock::duration waitTime;
+        if (getWaitTime(now, &waitTime))
         {
-            std::string message = "Error downloading " + taskIt->link + " : " + error->message;
-            taskIt->responsePath.set_exception(std::make_exception_ptr(std::runtime_error(message)));
+            startTask(waitTime);
         }
         else
         {
-            const gchar* dest = webkit_download_get_destination(download);
-            taskIt->responsePath.set_value(dest);
-        }
-        _tasksInProcess.erase(it);
-        bool hasNoMoreTasks = false;
-        {
-            std::unique_lock lock(_tasksMutex);
-            _tasks.erase(taskIt);
-            hasNoMoreTasks = _tasks.empty();
+            // all remaining tasks are either in process or their hosts are busy
+            stopWorker();
         }
+        return;
+    }
+
+    taskIt->isInProcess = true;
+    taskIt->startTime = now;
+    ++taskIt->numAttempts;
+    if (getSettings().isKeepDownloads())
+    {
+        taskIt->targetResponsePath = createTargetResponsePath(*taskIt);
+    }
+
+    downloadTask(taskIt, getBackend(*taskIt));
+}
+
+void CWebEngineDownloader::CImpl::preconnect(const DownloadTask& task)
+{
+    CDownloaderSettings settings = getSettings();
+    if (settings.isPreconnect() && _preconnectedHosts.insert(task.host).second)
+    {
+        // host never gets more connections at once than it is allowed to have tasks
+        int numConnections = std::min(settings.getMaxTasksPerHost(), settings.getNumWorkers());
+        getBackend(task).preconnect(task.link, numConnections);
+    }
+}
+
+void CWebEngineDownloader::CImpl::takeSubmittedTasks()
+{
+    DownloadTask::List submittedTasks = _submittedTasks.popAll();
+    for (auto taskIt = submittedTasks.begin(); taskIt != submittedTasks.end(); ++taskIt)
+    {
+        taskIt->sequenceNumber = ++_numTasksAdded;
+        _taskQueue.insert(taskIt);
+        preconnect(*taskIt);
+    }
+    // iterators stay valid after splice
+    auto firstSubmittedIt = submittedTasks.begin();
+    _tasks.splice(_tasks.end(), submittedTasks);
+    for (auto taskIt = firstSubmittedIt; taskIt != _tasks.end(); )
+    {
+        // token cancelled before adding removes the task at once
+        const DownloadTask& task = *taskIt++;
+        subscribeCancellation(task);
+    }
+    startWorkers();
+}
+
+void CWebEngineDownloader::CImpl::completeTask(DownloadTask::List::iterator taskIt, CDownloadResult&& result)
+{
+    if (taskIt->timeoutSourceId != 0)
+    {
+        g_source_remove(taskIt->timeoutSourceId);
+        taskIt->timeoutSourceId = 0;
+    }
+
+    if (taskIt->isCancelled)
+    {
+        // future has got its exception when task was cancelled
+        _scheduler.cancelTask(taskIt->host);
+        finishTask(taskIt);
+        return;
+    }
+
+    if (taskIt->isTimedOut)
+    {
+        auto timeout = getSettings().getTimeouts().getTotal();
+        result = CDownloadResult(0, "Error downloading " + taskIt->link + " : timed out after " + std::to_string(timeout.count()) + " ms");
+    }
 
-        if (hasNoMoreTasks && _tasksInProcess.empty())
+    EDownloadFailure failure = result.getFailure();
+    if (failure == EDownloadFailure::NONE)
+    {
+        if (taskIt->numAttempts > 1)
         {
-            waitForTask();
+            std::cerr << "Downloaded " << taskIt->link << " after " << taskIt->numAttempts << " attempts" << std::endl;
         }
+        taskIt->response.set_value(std::move(result.getContent()));
+        notifyCompletion(*taskIt);
+        _scheduler.completeTask(taskIt->host, result, taskIt->startTime, Clock::now());
+        finishTask(taskIt);
+    }
+    else if (_retryPolicy.isRetryAllowed(failure, taskIt->numAttempts))
+    {
+        retryTask(taskIt, result);
+    }
+    else if (isFallbackAllowed(*taskIt))
+    {
+        // web engine is kept as a fallback for pages which plain https request can't get
+        taskIt->isFallback = true;
+        taskIt->startTime = Clock::now();
+        ++taskIt->numAttempts;
+        downloadTask(taskIt, getWebKitBackend());
+    }
+    else
+    {
+        failTask(taskIt, result);
     }
 }
 
-void CWebEngineDownloader::CImpl::startDownloading(GtkApplication* app)
+void CWebEngineDownloader::CImpl::retryTask(DownloadTask::List::iterator taskIt, const CDownloadResult& result)
 {
-    GtkWidget* window = gtk_application_window_new(app);
-    gtk_window_set_title(GTK_WINDOW(window), "DummyWindow");
-    
-    _webView = webkit_web_view_new();
-    gtk_window_set_child(GTK_WINDOW(window), _webView);
-    
-    _numStepsUntilHugeBreak = getNumStepsBeforeHugeBreak();
-    _nextTask = _tasks.begin();
-    waitForTask();
+    Clock::time_point now = Clock::now();
+    EDownloadFailure failure = result.getFailure();
+    Clock::duration retryDelay = _retryPolicy.getRetryDelay(failure, taskIt->numAttempts);
+    std::cerr << result.getErrorMessage() << " (" << getDownloadFailure(failure) << " failure, attempt " << taskIt->numAttempts
+        << "), retry in " << std::chrono::ceil<std::chrono::milliseconds>(retryDelay).count() << " ms" << std::endl;
+
+    // host budget is released while task waits, failure also slows down the host
+    _scheduler.completeTask(taskIt->host, result, taskIt->startTime, now);
+    taskIt->isInProcess = false;
+    taskIt->retryTime = now + retryDelay;
+    _taskQueue.insert(taskIt);
+
+    --_numActiveWorkers;
+    startWorkers();
 }
 
-void CWebEngineDownloader::CImpl::onDownloadFinished(WebKitDownload* download, gpointer userData)
+void CWebEngineDownloader::CImpl::failTask(DownloadTask::List::iterator taskIt, const CDownloadResult& result)
 {
-    CImpl* ptrThis = static_cast<CImpl*>(userData);
-    return ptrThis->completeTask(download);
+    std::string errorMessage = result.getErrorMessage();
+    if (taskIt->numAttempts > 1)
+    {
+        errorMessage += " (failed after " + std::to_string(taskIt->numAttempts) + " attempts)";
+    }
+    taskIt->response.set_exception(std::make_exception_ptr(std::runtime_error(errorMessage)));
+    notifyCompletion(*taskIt);
+    _scheduler.completeTask(taskIt->host, result, taskIt->startTime, Clock::now());
+    finishTask(taskIt);
 }
 
-void CWebEngineDownloader::CImpl::onDownloadFailed(WebKitDownload* download, GError* error, gpointer userData)
+void CWebEngineDownloader::CImpl::notifyCompletion(DownloadTask& task)
 {
-    CImpl* ptrThis = static_cast<CImpl*>(userData);
-    return ptrThis->completeTask(download, error);    
+    if (task.handler)
+    {
+        CompletionHandler handler = std::move(task.handler);
+        task.handler = nullptr;
+        handler(std::move(task.handlerResponse));
+    }
 }
 
-gboolean CWebEngineDownloader::CImpl::onDecideDestination(WebKitDownload* download, gchar* suggestedFilename, gpointer userData)
+void CWebEngineDownloader::CImpl::finishTask(DownloadTask::List::iterator taskIt)
 {
-    CImpl* ptrThis = static_cast<CImpl*>(userData);
-    ptrThis->setDownloadDestination(download, suggestedFilename);    
-    return true;
+    _tasks.erase(taskIt);
+
+    // finished worker and workers stopped by busy host get the next tasks
+    --_numActiveWorkers;
+    startWorkers();
+}
+
+gboolean CWebEngineDownloader::CImpl::onDownloadCompleted(gpointer userData)
+{
+    std::unique_ptr<DownloadCompletion> completion(static_cast<DownloadCompletion*>(userData));
+    completion->ptrThis->completeTask(completion->taskIt, std::move(completion->result));
+    return G_SOURCE_REMOVE;
+}
+
+gboolean CWebEngineDownloader::CImpl::onDownloadCancelled(gpointer userData)
+{
+    std::unique_ptr<DownloadCancellation> cancellation(static_cast<DownloadCancellation*>(userData));
+    cancellation->ptrThis->cancelTask(cancellation->sequenceNumber);
+    return G_SOURCE_REMOVE;
+}
+
+void CWebEngineDownloader::CImpl::onDownloadTimeout(gpointer userData)
+{
+    DownloadTask* ptrTask = static_cast<DownloadTask*>(userData);
+    ptrTask->timeoutSourceId = 0;
+    ptrTask->isTimedOut = true;
+    // backend completes the attempt with error, task may be gone after this call
+    ptrTask->attemptCancellationToken.cancel();
 }
 
 void CWebEngineDownloader::CImpl::processTask(gpointer userData)
@@ -281,16 +621,16 @@ void CWebEngineDownloader::CImpl::processTask(gpointer userData)
     return ptrThis->processTask();
 }
 
-gboolean CWebEngineDownloader::CImpl::waitForTask(gpointer userData)
+void CWebEngineDownloader::CImpl::onQuit(gpointer userData)
 {
     CImpl* ptrThis = static_cast<CImpl*>(userData);
-    return ptrThis->hasTask() ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+    g_main_loop_quit(ptrThis->_mainLoop);
 }
 
-void CWebEngineDownloader::CImpl::onActivateApp(GtkApplication* app, gpointer userData)
+void CWebEngineDownloader::CImpl::onTasksSubmitted(gpointer userData)
 {
     CImpl* ptrThis = static_cast<CImpl*>(userData);
-    return ptrThis->startDownloading(app);
+    return ptrThis->takeSubmittedTasks();
 }
 
 std::shared_ptr<CWebEngineDownloader::CImpl> CWebEngineDownloader::CImpl::create()
@@ -299,19 +639,26 @@ std::shared_ptr<CWebEngineDownloader::CImpl> CWebEngineDownloader::CImpl::create
 }
 
 std::shared_ptr<CWebEngineDownloader::CImpl> CWebEngineDownloader::_pImpl;
+std::once_flag CWebEngineDownloader::_isImplCreated;
 
 void CWebEngineDownloader::checkDownloader()
 {
-    if (_pImpl == nullptr)
-    {
-        _pImpl = CImpl::create();
-    }    
+    // downloaders can be used from several threads at once
+    std::call_once(_isImplCreated, []() { _pImpl = CImpl::create(); });
+}
+
+CWebEngineDownloader::FutureResponseType CWebEngineDownloader::addDownload(std::string_view link, std::string_view responseName, int priority, TimePoint deadline,
+    const CCancellationToken& cancellationToken, const CResponseCutoff& cutoff)
+{
+    checkDownloader();
+    return _pImpl->addDownload(link, responseName, priority, deadline, cancellationToken, cutoff);
 }
 
-CWebEngineDownloader::FutureResponseType CWebEngineDownloader::addDownload(std::string_view link, std::string_view responseName)
+void CWebEngineDownloader::addDownload(std::string_view link, CompletionHandler handler, std::string_view responseName, int priority,
+    TimePoint deadline, const CCancellationToken& cancellationToken, const CResponseCutoff& cutoff)
 {
     checkDownloader();
-    return _pImpl->addDownload(link, responseName);
+    _pImpl->addDownload(link, responseName, priority, deadline, cancellationToken, cutoff, std::move(handler));
 }
 
 void CWebEngineDownloader::setDownloadDir(std::string_view dir)
@@ -319,4 +666,10 @@ void CWebEngineDownloader::setDownloadDir(std::string_view dir)
     checkDownloader();
     _pImpl->setDownloadDir(dir);
 }
+
+void CWebEngineDownloader::setSettings(const CDownloaderSettings& settings)
+{
+    checkDownloader();
+    _pImpl->setSettings(settings);
+}
 }
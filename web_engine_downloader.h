@@ -1,21 +1,40 @@
 #pragma once
 
+#include <chrono>
 #include <thread>
 #include <future>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include "downloader_settings.h"
+#include "cancellation_token.h"
 
 namespace watchList
 {
 class CWebEngineDownloader
 {
 public:
+    // content of the page, it is saved to download dir only if downloads are kept
     typedef std::string ResponseType;
     typedef std::future<ResponseType> FutureResponseType;
+    typedef std::chrono::steady_clock::time_point TimePoint;
+    // gets ready future of the response, it is called from downloader thread, so it should only hand the work over
+    typedef std::function<void(FutureResponseType&& response)> CompletionHandler;
     
 public:
-    FutureResponseType addDownload(std::string_view link, std::string_view responseName = std::string_view());
+    // Tasks with higher priority are downloaded first, tasks of the same priority are ordered by deadline.
+    // Future of cancelled task gets exception at once.
+    // Response ends where cutoff of its parser finds it, page size limit of settings is applied on top.
+    FutureResponseType addDownload(std::string_view link, std::string_view responseName = std::string_view(),
+        int priority = 0, TimePoint deadline = TimePoint::max(), const CCancellationToken& cancellationToken = CCancellationToken(),
+        const CResponseCutoff& cutoff = CResponseCutoff());
+    // the same download, but completion is reported to handler instead of caller waiting for the future
+    void addDownload(std::string_view link, CompletionHandler handler, std::string_view responseName = std::string_view(),
+        int priority = 0, TimePoint deadline = TimePoint::max(), const CCancellationToken& cancellationToken = CCancellationToken(),
+        const CResponseCutoff& cutoff = CResponseCutoff());
     void setDownloadDir(std::string_view dir);
+    void setSettings(const CDownloaderSettings& settings);
     
 private:
     void checkDownloader();
@@ -24,7 +43,8 @@ private:
     class CImpl;
     
 private:
-    // WebKitWebView allow creation only from one thread
+    // WebKitWebView allow creation only from one thread, so all downloads go through one main loop
     static std::shared_ptr<CImpl> _pImpl;
+    static std::once_flag _isImplCreated;
 };
 }
@@ -0,0 +1,289 @@
+#include <gtk/gtk.h>
+#include <webkit/webkit.h>
+#include <map>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <unistd.h>
+#include "webkit_download_backend.h"
+
+namespace watchList
+{
+class CWebKitDownloadBackend::CImpl
+{
+public:
+    CImpl(int numWebViews);
+    ~CImpl();
+
+public:
+    void download(const std::string& link, const std::string& destination, const CResponseCutoff& cutoff, CompletionHandler handler,
+        const CCancellationToken& cancellationToken);
+
+private:
+    bool checkWebViews();
+    WebKitWebView* getLeastBusyWebView() const;
+    void setDownloadDestination(WebKitDownload* download);
+    void completeDownload(WebKitDownload* download, GError* error = nullptr);
+    void cancelDownload(WebKitDownload* download);
+    std::string createTemporaryDestination();
+
+    static void readContent(const std::string& path, const CResponseCutoff& cutoff, std::string& content);
+    static bool isTruncated(WebKitDownload* download, WebKitURIResponse* response);
+
+private:
+    static gboolean onDecideDestination(WebKitDownload* download, gchar* suggestedFilename, gpointer userData);
+    static void onDownloadFinished(WebKitDownload* download, gpointer userData);
+    static void onDownloadFailed(WebKitDownload* download, GError* error, gpointer userData);
+    static gboolean onDownloadCancelled(gpointer userData);
+
+private:
+    struct DownloadInProcess
+    {
+        WebKitWebView* webView;
+        std::string link;
+        std::string destination;
+        bool isTemporaryDestination;
+        CResponseCutoff cutoff;
+        CompletionHandler handler;
+    };
+
+    struct DownloadCancellation
+    {
+        CImpl* ptrThis;
+        WebKitDownload* download;
+    };
+
+    typedef std::map<WebKitDownload*, DownloadInProcess> DownloadsInProcess;
+    typedef std::vector<GtkWidget*> WidgetList;
+
+private:
+    int _numWebViews;
+    bool _isGtkInitialized;
+    // every web view lives in its own dummy window
+    WidgetList _windows;
+    WidgetList _webViews;
+    DownloadsInProcess _downloadsInProcess;
+    int _numTemporaryDestinations;
+};
+
+CWebKitDownloadBackend::CImpl::CImpl(int numWebViews)
+    : _numWebViews(std::max(numWebViews, 1))
+    , _isGtkInitialized(false)
+    , _numTemporaryDestinations(0)
+{
+}
+
+CWebKitDownloadBackend::CImpl::~CImpl()
+{
+    for (GtkWidget* window : _windows)
+    {
+        gtk_window_destroy(GTK_WINDOW(window));
+    }
+}
+
+bool CWebKitDownloadBackend::CImpl::checkWebViews()
+{
+    if (_webViews.empty())
+    {
+        // gtk is initialized only when web engine is really needed, so https only runs work without display
+        _isGtkInitialized = _isGtkInitialized || gtk_init_check();
+        if (_isGtkInitialized)
+        {
+            for (int i = _numWebViews; i > 0; --i)
+            {
+                GtkWidget* window = gtk_window_new();
+                gtk_window_set_title(GTK_WINDOW(window), "DummyWindow");
+
+                GtkWidget* webView = webkit_web_view_new();
+                gtk_window_set_child(GTK_WINDOW(window), webView);
+
+                _windows.push_back(window);
+                _webViews.push_back(webView);
+            }
+        }
+    }
+    return !_webViews.empty();
+}
+
+WebKitWebView* CWebKitDownloadBackend::CImpl::getLeastBusyWebView() const
+{
+    auto getNumDownloads = [this](GtkWidget* webView)
+        {
+            return std::count_if(_downloadsInProcess.begin(), _downloadsInProcess.end(),
+                [webView](const auto& download)
+                {
+                    return download.second.webView == WEBKIT_WEB_VIEW(webView);
+                });
+        };
+    auto it = std::min_element(_webViews.begin(), _webViews.end(),
+        [&getNumDownloads](GtkWidget* first, GtkWidget* second)
+        {
+            return getNumDownloads(first) < getNumDownloads(second);
+        });
+    return WEBKIT_WEB_VIEW(*it);
+}
+
+void CWebKitDownloadBackend::CImpl::download(const std::string& link, const std::string& destination, const CResponseCutoff& cutoff,
+    CompletionHandler handler, const CCancellationToken& cancellationToken)
+{
+    if (!checkWebViews())
+    {
+        handler(CDownloadResult(0, "Error downloading " + link + " : can't initialize gtk, display is not available"));
+        return;
+    }
+
+    WebKitWebView* webView = getLeastBusyWebView();
+    WebKitDownload* download = webkit_web_view_download_uri(webView, link.c_str());
+    g_signal_connect(download, "failed", G_CALLBACK(onDownloadFailed), this);
+    g_signal_connect(download, "finished", G_CALLBACK(onDownloadFinished), this);
+    g_signal_connect(download, "decide-destination", G_CALLBACK(onDecideDestination), this);
+    // web engine can only download to file, so the file is removed after reading if caller doesn't keep it
+    bool isTemporaryDestination = destination.empty();
+    std::string downloadDestination = isTemporaryDestination ? createTemporaryDestination() : destination;
+    _downloadsInProcess[download] = DownloadInProcess{ webView, link, downloadDestination, isTemporaryDestination, cutoff, std::move(handler) };
+
+    cancellationToken.subscribe(
+        [this, download]()
+        {
+            // token may be cancelled from other thread, web engine is used only from main loop
+            g_main_context_invoke(nullptr, onDownloadCancelled, new DownloadCancellation{ this, download });
+        });
+}
+
+void CWebKitDownloadBackend::CImpl::cancelDownload(WebKitDownload* download)
+{
+    // download could be already completed, failed signal completes it otherwise
+    if (_downloadsInProcess.count(download) != 0)
+    {
+        webkit_download_cancel(download);
+    }
+}
+
+gboolean CWebKitDownloadBackend::CImpl::onDownloadCancelled(gpointer userData)
+{
+    std::unique_ptr<DownloadCancellation> cancellation(static_cast<DownloadCancellation*>(userData));
+    cancellation->ptrThis->cancelDownload(cancellation->download);
+    return G_SOURCE_REMOVE;
+}
+
+std::string CWebKitDownloadBackend::CImpl::createTemporaryDestination()
+{
+    std::string fileName = "japanwatchlist_" + std::to_string(getpid()) + "_" + std::to_string(++_numTemporaryDestinations);
+    return (std::filesystem::temp_directory_path() / fileName).string();
+}
+
+void CWebKitDownloadBackend::CImpl::readContent(const std::string& path, const CResponseCutoff& cutoff, std::string& content)
+{
+    std::ifstream contentFile;
+    contentFile.exceptions(std::ios::failbit | std::ios::badbit);
+    contentFile.open(path, std::ios::binary);
+    content.resize(std::filesystem::file_size(path));
+    contentFile.read(content.data(), content.size());
+
+    // web engine always downloads the whole page, only the content is cut
+    std::size_t contentEnd = cutoff.findEnd(content);
+    if (contentEnd != std::string::npos)
+    {
+        content.resize(contentEnd);
+    }
+}
+
+bool CWebKitDownloadBackend::CImpl::isTruncated(WebKitDownload* download, WebKitURIResponse* response)
+{
+    // content length is unknown for chunked responses, compressed page is received bigger than its length
+    guint64 contentLength = (response == nullptr) ? 0 : webkit_uri_response_get_content_length(response);
+    return (contentLength != 0) && (webkit_download_get_received_data_length(download) < contentLength);
+}
+
+void CWebKitDownloadBackend::CImpl::setDownloadDestination(WebKitDownload* download)
+{
+    auto it = _downloadsInProcess.find(download);
+    if (it != _downloadsInProcess.end())
+    {
+        webkit_download_set_destination(download, it->second.destination.c_str());
+    }
+}
+
+void CWebKitDownloadBackend::CImpl::completeDownload(WebKitDownload* download, GError* error)
+{
+    auto it = _downloadsInProcess.find(download);
+    if (it != _downloadsInProcess.end())
+    {
+        DownloadInProcess downloadInProcess = std::move(it->second);
+        _downloadsInProcess.erase(it);
+        WebKitURIResponse* response = webkit_download_get_response(download);
+        int statusCode = (response == nullptr) ? 0 : webkit_uri_response_get_status_code(response);
+        if (error != nullptr)
+        {
+            downloadInProcess.handler(CDownloadResult(statusCode, "Error downloading " + downloadInProcess.link + " : " + error->message));
+        }
+        else if ((statusCode != 0) && (statusCode / 100 != 2))
+        {
+            downloadInProcess.handler(CDownloadResult(statusCode, "Error downloading " + downloadInProcess.link + " : HTTP status " + std::to_string(statusCode)));
+        }
+        else if (isTruncated(download, response))
+        {
+            downloadInProcess.handler(CDownloadResult(statusCode, "Error downloading " + downloadInProcess.link + " : page is truncated", true));
+        }
+        else
+        {
+            CDownloadResult result(statusCode);
+            try
+            {
+                readContent(downloadInProcess.destination, downloadInProcess.cutoff, result.getContent());
+            }
+            catch (const std::exception& ex)
+            {
+                result = CDownloadResult(statusCode, "Error reading " + downloadInProcess.link + " : " + ex.what());
+            }
+            downloadInProcess.handler(std::move(result));
+        }
+
+        if (downloadInProcess.isTemporaryDestination)
+        {
+            std::error_code errorCode;
+            std::filesystem::remove(downloadInProcess.destination, errorCode);
+        }
+    }
+}
+
+void CWebKitDownloadBackend::CImpl::onDownloadFinished(WebKitDownload* download, gpointer userData)
+{
+    CImpl* ptrThis = static_cast<CImpl*>(userData);
+    return ptrThis->completeDownload(download);
+}
+
+void CWebKitDownloadBackend::CImpl::onDownloadFailed(WebKitDownload* download, GError* error, gpointer userData)
+{
+    CImpl* ptrThis = static_cast<CImpl*>(userData);
+    return ptrThis->completeDownload(download, error);
+}
+
+gboolean CWebKitDownloadBackend::CImpl::onDecideDestination(WebKitDownload* download, gchar* /*suggestedFilename*/, gpointer userData)
+{
+    CImpl* ptrThis = static_cast<CImpl*>(userData);
+    ptrThis->setDownloadDestination(download);
+    return true;
+}
+
+CWebKitDownloadBackend::CWebKitDownloadBackend(int numWebViews)
+    : _pImpl(std::make_unique<CImpl>(numWebViews))
+{
+}
+
+CWebKitDownloadBackend::~CWebKitDownloadBackend()
+{
+}
+
+bool CWebKitDownloadBackend::isSupported(std::string_view /*link*/) const
+{
+    return true;
+}
+
+void CWebKitDownloadBackend::download(const std::string& link, const std::string& destination, const CResponseCutoff& cutoff,
+    CompletionHandler handler, const CCancellationToken& cancellationToken)
+{
+    _pImpl->download(link, destination, cutoff, std::move(handler), cancellationToken);
+}
+}
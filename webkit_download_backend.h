@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include "download_backend.h"
+
+namespace watchList
+{
+    // Fetches pages through pool of WebKitWebView, requires display.
+    // All methods must be called from the thread running glib default main context.
+    class CWebKitDownloadBackend : public CDownloadBackend
+    {
+    public:
+        CWebKitDownloadBackend(int numWebViews = 1);
+        ~CWebKitDownloadBackend();
+
+    public:
+        bool isSupported(std::string_view link) const override;
+        void download(const std::string& link, const std::string& destination, const CResponseCutoff& cutoff,
+            CompletionHandler handler, const CCancellationToken& cancellationToken) override;
+
+    private:
+        class CImpl;
+
+    private:
+        std::unique_ptr<CImpl> _pImpl;
+    };
+}
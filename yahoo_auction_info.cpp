@@ -7,15 +7,28 @@ std::string_view CYahooAuctionInfoHtmlParser::HTML_TAG_DATA_AUCTION_ID = "data-a
 std::string_view CYahooAuctionInfoHtmlParser::HTML_TAG_DATA_AUCTION_TITLE = "data-auction-title";
 std::string_view CYahooAuctionInfoHtmlParser::HTML_TAG_DATA_AUCTION_IMAGE = "data-auction-img";
 std::string_view CYahooAuctionInfoHtmlParser::HTML_TAG_DATA_AUCTION_PRICE = "data-auction-price";
+std::string_view CYahooAuctionInfoHtmlParser::HTML_TAG_FOOTER = "<footer";
 
 CYahooAuctionInfo::CYahooAuctionInfo()
 {
 }
 
-CYahooAuctionInfoHtmlParser::CYahooAuctionInfoHtmlParser(const std::stringstream& response)
-    : _content(response)
+CYahooAuctionInfoHtmlParser::CYahooAuctionInfoHtmlParser(std::string&& response)
+    : _content(std::move(response))
 {
     _parser = _content.createParser();
+    // footer is the end anchor of both parser and response cutoff, so cut and full pages give the same items
+    CHtmlParser parserBeforeFooter = _parser;
+    parserBeforeFooter.skipEnding(HTML_TAG_FOOTER);
+    if (parserBeforeFooter.hasContent())
+    {
+        _parser = parserBeforeFooter;
+    }
+}
+
+CResponseCutoff CYahooAuctionInfoHtmlParser::getResponseCutoff()
+{
+    return CResponseCutoff(HTML_TAG_FOOTER);
 }
 
 bool CYahooAuctionInfoHtmlParser::hasNext()
@@ -40,7 +40,7 @@ namespace watchList
     class CYahooAuctionInfoHtmlParser
     {
     public:
-        CYahooAuctionInfoHtmlParser(const std::stringstream& response);
+        CYahooAuctionInfoHtmlParser(std::string&& response);
         
     public:
         bool hasNext();
@@ -48,12 +48,16 @@ namespace watchList
         const CYahooAuctionInfo& next() const
             { return _currentAuctionInfo; }
 
+        // auctions are looked for only before page footer, so footer and the rest of the page aren't downloaded
+        static CResponseCutoff getResponseCutoff();
+
     private:
         static std::string_view HTML_CLASS_PRODUCT_TITLE;
         static std::string_view HTML_TAG_DATA_AUCTION_ID;
         static std::string_view HTML_TAG_DATA_AUCTION_TITLE;
         static std::string_view HTML_TAG_DATA_AUCTION_IMAGE;
         static std::string_view HTML_TAG_DATA_AUCTION_PRICE;
+        static std::string_view HTML_TAG_FOOTER;
 
     private:
         CHtmlContent _content;
@@ -0,0 +1,35 @@
+#include "yahoo_item_condition.h"
+
+namespace watchList
+{
+    static std::string_view ANY_ITEM_CONDITION_STR = "any";
+    static std::string_view NEW_ITEM_CONDITION_STR = "new";
+    static std::string_view USED_ITEM_CONDITION_STR = "used";
+    
+    EYahooItemCondition getYahooItemCondition(std::string_view condition)
+    {
+        if (condition == NEW_ITEM_CONDITION_STR)
+        {
+            return EYahooItemCondition::NEW;
+        }
+        else if (condition == USED_ITEM_CONDITION_STR)
+        {
+            return EYahooItemCondition::USED;
+        }
+        return EYahooItemCondition::ANY;
+    }
+    
+    std::string_view getYahooItemCondition(EYahooItemCondition condition)
+    {
+        switch (condition)
+        {
+            case EYahooItemCondition::ANY:
+                return ANY_ITEM_CONDITION_STR;
+            case EYahooItemCondition::NEW:
+                return NEW_ITEM_CONDITION_STR;
+            case EYahooItemCondition::USED:
+                return USED_ITEM_CONDITION_STR;
+        }
+        return ANY_ITEM_CONDITION_STR;
+    }
+}
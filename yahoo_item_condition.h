@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+namespace watchList
+{
+    enum class EYahooItemCondition
+    {
+        ANY = 0,
+        NEW,
+        USED
+    };
+    
+    EYahooItemCondition getYahooItemCondition(std::string_view condition);
+    std::string_view getYahooItemCondition(EYahooItemCondition condition);
+}
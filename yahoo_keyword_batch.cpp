@@ -0,0 +1,233 @@
+#include <map>
+#include <tuple>
+#include <numeric>
+#include <algorithm>
+#include "yahoo_keyword_batch.h"
+
+namespace watchList
+{
+std::size_t CYahooKeywordBatch::MAX_BATCH_SIZE = 10;
+std::size_t CYahooKeywordBatch::MAX_OR_WORDS_LENGTH = 400;
+
+CYahooKeywordBatch::CYahooKeywordBatch(const CYahooSearchQuery& searchQuery)
+    : _searchQuery(searchQuery)
+    , _searchQueries(1, searchQuery)
+    , _orWordsLength(0)
+    , _isCategoryFeed(false)
+    , _isCoveringSearch(false)
+    , _searchedQueryIndex(0)
+{
+    CKeywordMatcher::Keyword keyword = CKeywordMatcher::parseKeyword(searchQuery.getKeyword());
+    if (!keyword.words.empty())
+    {
+        _orWords.push_back(getOrWord(keyword));
+        _orWordsLength = getUrlLength(_orWords.front());
+    }
+}
+
+std::size_t CYahooKeywordBatch::getUrlLength(std::string_view word)
+{
+    return std::accumulate(word.begin(), word.end(), std::size_t(0),
+        [](std::size_t length, char ch) { return length + ((static_cast<unsigned char>(ch) < 0x80) ? 1 : 3); });
+}
+
+bool CYahooKeywordBatch::isBatchable(const CYahooSearchQuery& searchQuery, const CKeywordMatcher::Keyword& keyword)
+{
+    return (searchQuery.getSearchMethod() == EYahooSearchMethod::TITLE) && !keyword.words.empty();
+}
+
+bool CYahooKeywordBatch::isCovering(const CYahooSearchQuery& searchQuery, const CKeywordMatcher::Keyword& keyword)
+{
+    return (searchQuery.getSearchMethod() == EYahooSearchMethod::TITLE_AND_DESCRIPTION) && !keyword.words.empty()
+        && keyword.excludedWords.empty();
+}
+
+const std::string& CYahooKeywordBatch::getOrWord(const CKeywordMatcher::Keyword& keyword)
+{
+    return *std::max_element(keyword.words.begin(), keyword.words.end(),
+        [](const std::string& left, const std::string& right) { return left.size() < right.size(); });
+}
+
+std::string CYahooKeywordBatch::createResponseName() const
+{
+    if (_isCategoryFeed)
+    {
+        std::string responseName = "feed " + _searchQuery.getCategoryName();
+        if (!_searchQuery.getFilter().isEmpty())
+        {
+            responseName += " " + _searchQuery.getFilter().createName();
+        }
+        return responseName;
+    }
+    std::string responseName = _searchQueries[_searchedQueryIndex].createResponseName();
+    if (isBatch())
+    {
+        // names of all keywords don't fit into file name
+        responseName += " +" + std::to_string(_searchQueries.size() - 1);
+    }
+    return responseName;
+}
+
+std::vector<std::size_t> CYahooKeywordBatch::match(std::string_view title) const
+{
+    if (_isCoveringSearch)
+    {
+        std::vector<std::size_t> queryIndexes = _ptrMatcher->match(title);
+        auto itSearchedQuery = std::lower_bound(queryIndexes.begin(), queryIndexes.end(), _searchedQueryIndex);
+        if ((itSearchedQuery == queryIndexes.end()) || (*itSearchedQuery != _searchedQueryIndex))
+        {
+            queryIndexes.insert(itSearchedQuery, _searchedQueryIndex);
+        }
+        return queryIndexes;
+    }
+    if (!isBatch())
+    {
+        // Yahoo has matched the keyword itself, description as well
+        return std::vector<std::size_t>(1, _searchedQueryIndex);
+    }
+    return _ptrMatcher->match(title);
+}
+
+void CYahooKeywordBatch::addQuery(const CYahooSearchQuery& searchQuery)
+{
+    _searchQuery._priority = std::max(_searchQuery.getPriority(), searchQuery.getPriority());
+    if ((_searchQuery.getDeadlineSeconds() == 0) || ((searchQuery.getDeadlineSeconds() != 0)
+        && (searchQuery.getDeadlineSeconds() < _searchQuery.getDeadlineSeconds())))
+    {
+        _searchQuery._deadlineSeconds = searchQuery.getDeadlineSeconds();
+    }
+    _searchQueries.push_back(searchQuery);
+}
+
+void CYahooKeywordBatch::addCoveredQuery(const CYahooSearchQuery& searchQuery, bool isBeforeSearchedQuery)
+{
+    _isCoveringSearch = true;
+    addQuery(searchQuery);
+    if (isBeforeSearchedQuery)
+    {
+        std::rotate(_searchQueries.begin() + _searchedQueryIndex, _searchQueries.end() - 1, _searchQueries.end());
+        ++_searchedQueryIndex;
+    }
+}
+
+bool CYahooKeywordBatch::add(const CYahooSearchQuery& searchQuery, const CKeywordMatcher::Keyword& keyword)
+{
+    const std::string& orWord = getOrWord(keyword);
+    bool isNewOrWord = std::find(_orWords.begin(), _orWords.end(), orWord) == _orWords.end();
+    std::size_t orWordsLength = _orWordsLength + (isNewOrWord ? getUrlLength(orWord) + 1 : 0);
+    if ((_searchQueries.size() >= MAX_BATCH_SIZE) || (orWordsLength > MAX_OR_WORDS_LENGTH))
+    {
+        return false;
+    }
+
+    if (isNewOrWord)
+    {
+        _orWords.push_back(orWord);
+        _orWordsLength = orWordsLength;
+    }
+    addQuery(searchQuery);
+    return true;
+}
+
+void CYahooKeywordBatch::createMatcher()
+{
+    std::vector<std::string> keywords;
+    for (const CYahooSearchQuery& searchQuery : _searchQueries)
+    {
+        keywords.push_back(searchQuery.getKeyword());
+    }
+    _ptrMatcher = std::make_shared<CKeywordMatcher>(keywords);
+}
+
+CYahooKeywordBatch::List CYahooKeywordBatch::plan(const std::vector<CYahooSearchQuery>& searchQueries)
+{
+    // keyword, category and filter of covering searches
+    typedef std::tuple<std::string, std::string, CYahooSearchFilter> SearchKey;
+    // covering query and index of its batch
+    typedef std::pair<const CYahooSearchQuery*, std::size_t> CoveringSearch;
+    std::map<SearchKey, CoveringSearch> coveringSearches;
+    for (const CYahooSearchQuery& searchQuery : searchQueries)
+    {
+        if (isCovering(searchQuery, CKeywordMatcher::parseKeyword(searchQuery.getKeyword())))
+        {
+            coveringSearches.emplace(SearchKey(searchQuery.getKeyword(), searchQuery.getCategory(), searchQuery.getFilter()),
+                CoveringSearch(&searchQuery, 0));
+        }
+    }
+
+    List batches;
+    std::vector<const CYahooSearchQuery*> coveredQueries;
+    // the last batch of each category and filter which still takes keywords
+    std::map<CategoryKey, std::size_t> openBatches;
+    for (const CYahooSearchQuery& searchQuery : searchQueries)
+    {
+        CKeywordMatcher::Keyword keyword = CKeywordMatcher::parseKeyword(searchQuery.getKeyword());
+        auto itCoveringSearch = coveringSearches.find(SearchKey(searchQuery.getKeyword(), searchQuery.getCategory(), searchQuery.getFilter()));
+        if ((itCoveringSearch != coveringSearches.end()) && (searchQuery.getSearchMethod() == EYahooSearchMethod::TITLE))
+        {
+            coveredQueries.push_back(&searchQuery);
+            continue;
+        }
+        if (!isBatchable(searchQuery, keyword))
+        {
+            if (itCoveringSearch != coveringSearches.end())
+            {
+                itCoveringSearch->second.second = batches.size();
+            }
+            batches.emplace_back(searchQuery);
+            continue;
+        }
+
+        CategoryKey categoryKey(searchQuery.getCategory(), searchQuery.getFilter());
+        auto itOpenBatch = openBatches.find(categoryKey);
+        if ((itOpenBatch == openBatches.end()) || !batches[itOpenBatch->second].add(searchQuery, keyword))
+        {
+            openBatches[categoryKey] = batches.size();
+            batches.emplace_back(searchQuery);
+        }
+    }
+    for (const CYahooSearchQuery* ptrSearchQuery : coveredQueries)
+    {
+        const CoveringSearch& coveringSearch = coveringSearches.at(SearchKey(ptrSearchQuery->getKeyword(), ptrSearchQuery->getCategory(),
+            ptrSearchQuery->getFilter()));
+        // both queries are elements of searchQueries
+        batches[coveringSearch.second].addCoveredQuery(*ptrSearchQuery, ptrSearchQuery < coveringSearch.first);
+    }
+    for (CYahooKeywordBatch& batch : batches)
+    {
+        if (batch.isBatch() || batch._isCoveringSearch)
+        {
+            batch.createMatcher();
+        }
+    }
+    return batches;
+}
+
+CYahooKeywordBatch::List CYahooKeywordBatch::planCategoryFeeds(const std::vector<CYahooSearchQuery>& searchQueries)
+{
+    List feeds;
+    // keywords with filter get feed of their own, filter goes to its url
+    std::map<CategoryKey, std::size_t> categoryFeeds;
+    for (const CYahooSearchQuery& searchQuery : searchQueries)
+    {
+        CategoryKey categoryKey(searchQuery.getCategory(), searchQuery.getFilter());
+        auto itFeed = categoryFeeds.find(categoryKey);
+        if (itFeed == categoryFeeds.end())
+        {
+            categoryFeeds.emplace(categoryKey, feeds.size());
+            feeds.emplace_back(searchQuery);
+            feeds.back()._isCategoryFeed = true;
+            feeds.back()._orWords.clear();
+        }
+        else
+        {
+            feeds[itFeed->second].addQuery(searchQuery);
+        }
+    }
+    for (CYahooKeywordBatch& feed : feeds)
+    {
+        feed.createMatcher();
+    }
+    return feeds;
+}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "yahoo_search_query.h"
+#include "keyword_matcher.h"
+
+namespace watchList
+{
+    // Title searches of the same category are packed into one OR query of Yahoo, so long tail of keywords
+    // takes a few page downloads instead of one per keyword. Auctions of the page are matched back to keywords by title.
+    // Category feed is a batch of all queries of category, which downloads the newest auctions of category without keyword.
+    // Title search of keyword is covered by title and description search of the same keyword and category,
+    // it takes auctions of the broader search which match its keyword by title.
+    class CYahooKeywordBatch
+    {
+    public:
+        typedef std::vector<CYahooKeywordBatch> List;
+
+    public:
+        // batch of one query searches its keyword as is
+        CYahooKeywordBatch(const CYahooSearchQuery& searchQuery);
+
+    public:
+        // auctions are matched to queries locally
+        bool isBatch() const
+            { return ((_searchQueries.size() > 1) && !_isCoveringSearch) || _isCategoryFeed; }
+
+        bool isCategoryFeed() const
+            { return _isCategoryFeed; }
+
+        // category and search method of batch, the highest priority and the earliest deadline of its queries
+        const CYahooSearchQuery& getSearchQuery() const
+            { return _searchQuery; }
+
+        const std::vector<CYahooSearchQuery>& getSearchQueries() const
+            { return _searchQueries; }
+
+        // one word of every keyword, Yahoo finds titles with any of them
+        const std::vector<std::string>& getOrWords() const
+            { return _orWords; }
+
+        std::string createResponseName() const;
+
+        // Indexes of queries which keywords are found in title in ascending order, see CKeywordMatcher.
+        // Searched query of single or covering search matches any title, Yahoo has matched its keyword.
+        std::vector<std::size_t> match(std::string_view title) const;
+
+        // Queries which can't be batched get batch of their own, covered queries go to batch of their covering search.
+        // Batches keep order of their queries, so auction found by several queries is credited to the first one of keywords file.
+        static List plan(const std::vector<CYahooSearchQuery>& searchQueries);
+        // one feed per category, queries of all search methods are matched by title with the same whole word rule as batches
+        static List planCategoryFeeds(const std::vector<CYahooSearchQuery>& searchQueries);
+
+    private:
+        // queries are batched only with queries of the same category and filter
+        typedef std::pair<std::string, CYahooSearchFilter> CategoryKey;
+
+    private:
+        static std::size_t MAX_BATCH_SIZE;
+        static std::size_t MAX_OR_WORDS_LENGTH;
+
+    private:
+        // length of word in url, characters besides ascii are percent encoded
+        static std::size_t getUrlLength(std::string_view word);
+        // only title search finds the same auctions as title matching
+        static bool isBatchable(const CYahooSearchQuery& searchQuery, const CKeywordMatcher::Keyword& keyword);
+        // Yahoo applies excluded words to description as well, so search with them doesn't cover title search
+        static bool isCovering(const CYahooSearchQuery& searchQuery, const CKeywordMatcher::Keyword& keyword);
+        // the longest word is the rarest one usually, so the batch downloads less auctions of other keywords
+        static const std::string& getOrWord(const CKeywordMatcher::Keyword& keyword);
+
+        bool add(const CYahooSearchQuery& searchQuery, const CKeywordMatcher::Keyword& keyword);
+        // query of batch takes the highest priority and the earliest deadline
+        void addQuery(const CYahooSearchQuery& searchQuery);
+        // query goes before or after searched query as it is in keywords file
+        void addCoveredQuery(const CYahooSearchQuery& searchQuery, bool isBeforeSearchedQuery);
+        void createMatcher();
+
+    private:
+        CYahooSearchQuery _searchQuery;
+        std::vector<CYahooSearchQuery> _searchQueries;
+        std::vector<std::string> _orWords;
+        std::size_t _orWordsLength;
+        bool _isCategoryFeed;
+        // searched query covers the rest
+        bool _isCoveringSearch;
+        std::size_t _searchedQueryIndex;
+        // batches are copied to tasks, they share matcher
+        std::shared_ptr<const CKeywordMatcher> _ptrMatcher;
+    };
+}
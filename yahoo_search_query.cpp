@@ -1,4 +1,5 @@
 #include <map>
+#include <tuple>
 #include <boost/algorithm/string.hpp>
 #include "yahoo_search_query.h"
 
@@ -26,8 +27,49 @@ namespace detail
     }
 }
     
+CYahooSearchFilter::CYahooSearchFilter()
+    : _minPriceJpy(0)
+    , _maxPriceJpy(0)
+    , _isBuyNowOnly(false)
+    , _condition(EYahooItemCondition::ANY)
+{
+}
+
+bool CYahooSearchFilter::isEmpty() const
+{
+    return (_minPriceJpy == 0) && (_maxPriceJpy == 0) && !_isBuyNowOnly && (_condition == EYahooItemCondition::ANY);
+}
+
+std::string CYahooSearchFilter::createName() const
+{
+    std::string name;
+    if ((_minPriceJpy != 0) || (_maxPriceJpy != 0))
+    {
+        name += std::to_string(_minPriceJpy) + "-" + ((_maxPriceJpy != 0) ? std::to_string(_maxPriceJpy) : std::string()) + " JPY";
+    }
+    if (_isBuyNowOnly)
+    {
+        name += name.empty() ? "" : " ";
+        name += "buy now";
+    }
+    if (_condition != EYahooItemCondition::ANY)
+    {
+        name += name.empty() ? "" : " ";
+        name += getYahooItemCondition(_condition);
+    }
+    return name;
+}
+
+bool CYahooSearchFilter::operator<(const CYahooSearchFilter& other) const
+{
+    return std::tie(_minPriceJpy, _maxPriceJpy, _isBuyNowOnly, _condition)
+        < std::tie(other._minPriceJpy, other._maxPriceJpy, other._isBuyNowOnly, other._condition);
+}
+
 CYahooSearchQuery::CYahooSearchQuery()
     :_searchMethod(EYahooSearchMethod::TITLE)
+    , _priority(0)
+    , _deadlineSeconds(0)
 {
 }
 
@@ -43,6 +85,10 @@ std::string CYahooSearchQuery::createResponseName() const
     std::string responseName = _keyword + " ";
     responseName += getCategoryName() + " ";
     responseName += getYahooSearchMethod(_searchMethod);
+    if (!_filter.isEmpty())
+    {
+        responseName += " " + _filter.createName();
+    }
     return responseName;
 }
 
@@ -62,7 +108,11 @@ bool CYahooSearchQuery::operator<(const CYahooSearchQuery& other) const
         }
         else if (cmpResult == 0)
         {
-            return _searchMethod < other.getSearchMethod();
+            if (_searchMethod != other.getSearchMethod())
+            {
+                return _searchMethod < other.getSearchMethod();
+            }
+            return _filter < other._filter;
         }
     }
     return false;
@@ -70,10 +120,18 @@ bool CYahooSearchQuery::operator<(const CYahooSearchQuery& other) const
 
 std::string_view CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::PARAM_NAME_CATEGORIES = "-categories:";
 std::string_view CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::PARAM_NAME_SEARCH_METHOD = "-searchMethod:";
+std::string_view CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::PARAM_NAME_PRIORITY = "-priority:";
+std::string_view CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::PARAM_NAME_DEADLINE = "-deadline:";
+std::string_view CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::PARAM_NAME_MIN_PRICE = "-minPrice:";
+std::string_view CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::PARAM_NAME_MAX_PRICE = "-maxPrice:";
+std::string_view CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::PARAM_NAME_BUY_NOW = "-buyNow:";
+std::string_view CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::PARAM_NAME_CONDITION = "-condition:";
 
 CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::CSearchParamsParser()
     :_categories(getDefaultCategories())
     , _searchMethod(getDefaultSearchMethod())
+    , _priority(0)
+    , _deadlineSeconds(0)
 {
 }
 
@@ -108,12 +166,46 @@ void CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::parse(std::string
     }    
 }
 
+void CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::parse(std::string_view line, std::string_view paramName, int& value)
+{
+    std::string_view strValue = getParamValue(line, paramName);
+    if (!strValue.empty())
+    {
+        value = std::stoi(std::string(strValue));
+    }
+}
+
+void CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::parse(std::string_view line, std::string_view paramName, bool& value)
+{
+    std::string_view strValue = getParamValue(line, paramName);
+    if (!strValue.empty())
+    {
+        value = (strValue == "1") || (strValue == "yes");
+    }
+}
+
+void CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::parse(std::string_view line, EYahooItemCondition& condition)
+{
+    std::string_view value = getParamValue(line, PARAM_NAME_CONDITION);
+    if (!value.empty())
+    {
+        condition = getYahooItemCondition(value);
+    }
+}
+
 bool CYahooKeywordsFileSearchQueryParser::CSearchParamsParser::parse(const std::string& line)
 {
     if (isParametersLine(line))
     {
         parse(line, PARAM_NAME_CATEGORIES, _categories);
         parse(line, _searchMethod);
+        parse(line, PARAM_NAME_PRIORITY, _priority);
+        parse(line, PARAM_NAME_DEADLINE, _deadlineSeconds);
+        // filter stays for the following keywords, zero price or "any" condition clears it
+        parse(line, PARAM_NAME_MIN_PRICE, _filter._minPriceJpy);
+        parse(line, PARAM_NAME_MAX_PRICE, _filter._maxPriceJpy);
+        parse(line, PARAM_NAME_BUY_NOW, _filter._isBuyNowOnly);
+        parse(line, _filter._condition);
         return true;
     }
     return false;
@@ -148,6 +240,9 @@ void CYahooKeywordsFileSearchQueryParser::setCurrentSearchQuery()
     _currentSearchQuery._category = _paramsParser.getCategories()[_categoryIndex];
     _currentSearchQuery._keyword = _keywordsLine;
     _currentSearchQuery._searchMethod = _paramsParser.getSearchMehod();
+    _currentSearchQuery._priority = _paramsParser.getPriority();
+    _currentSearchQuery._deadlineSeconds = _paramsParser.getDeadlineSeconds();
+    _currentSearchQuery._filter = _paramsParser.getFilter();
     _categoryIndex++;
 }
 
@@ -4,9 +4,47 @@
 #include <fstream>
 #include <vector>
 #include "yahoo_search_method.h"
+#include "yahoo_item_condition.h"
 
 namespace watchList
 {
+    // Filter goes to search url, so auctions which don't pass it aren't downloaded at all
+    class CYahooSearchFilter
+    {
+        friend class CYahooKeywordsFileSearchQueryParser;
+
+    public:
+        // zero if there is no limit
+        int getMinPriceJpy() const
+            { return _minPriceJpy; }
+
+        int getMaxPriceJpy() const
+            { return _maxPriceJpy; }
+
+        // auctions with buy it now price only
+        bool isBuyNowOnly() const
+            { return _isBuyNowOnly; }
+
+        EYahooItemCondition getCondition() const
+            { return _condition; }
+
+        bool isEmpty() const;
+        // empty if filter is empty
+        std::string createName() const;
+
+    public:
+        bool operator<(const CYahooSearchFilter& other) const;
+
+    public:
+        CYahooSearchFilter();
+
+    private:
+        int _minPriceJpy;
+        int _maxPriceJpy;
+        bool _isBuyNowOnly;
+        EYahooItemCondition _condition;
+    };
+
     class CYahooSearchQuery
     {
         friend class CYahooKeywordsFileSearchQueryParser;
@@ -22,6 +60,17 @@ namespace watchList
             { return _category; }           
             
         const std::string& getCategoryName() const;
+
+        // queries with higher priority are downloaded first
+        int getPriority() const
+            { return _priority; }
+
+        // query should be downloaded within this number of seconds after it is added, zero if there is no deadline
+        int getDeadlineSeconds() const
+            { return _deadlineSeconds; }
+
+        const CYahooSearchFilter& getFilter() const
+            { return _filter; }
         
         std::string createResponseName() const;
         
@@ -35,6 +84,9 @@ namespace watchList
         std::string _keyword;
         std::string _category;
         EYahooSearchMethod _searchMethod;
+        int _priority;
+        int _deadlineSeconds;
+        CYahooSearchFilter _filter;
     };
     
     class CYahooKeywordsFileSearchQueryParser
@@ -69,10 +121,25 @@ namespace watchList
                 
             EYahooSearchMethod getSearchMehod() const
                 { return _searchMethod; }
+
+            int getPriority() const
+                { return _priority; }
+
+            int getDeadlineSeconds() const
+                { return _deadlineSeconds; }
+
+            const CYahooSearchFilter& getFilter() const
+                { return _filter; }
                 
         private:
             static std::string_view PARAM_NAME_CATEGORIES;
             static std::string_view PARAM_NAME_SEARCH_METHOD;
+            static std::string_view PARAM_NAME_PRIORITY;
+            static std::string_view PARAM_NAME_DEADLINE;
+            static std::string_view PARAM_NAME_MIN_PRICE;
+            static std::string_view PARAM_NAME_MAX_PRICE;
+            static std::string_view PARAM_NAME_BUY_NOW;
+            static std::string_view PARAM_NAME_CONDITION;
 
         private:
             static bool isParametersLine(std::string_view line);
@@ -81,12 +148,18 @@ namespace watchList
             
             static void parse(std::string_view line, std::string_view paramName, StringParamList& strList);
             static void parse(std::string_view line, EYahooSearchMethod& _searchMethod);
+            static void parse(std::string_view line, std::string_view paramName, int& value);
+            static void parse(std::string_view line, std::string_view paramName, bool& value);
+            static void parse(std::string_view line, EYahooItemCondition& condition);
             
             static std::string_view getParamValue(std::string_view line, std::string_view paramName);
             
         private:
             StringParamList _categories;
             EYahooSearchMethod _searchMethod;
+            int _priority;
+            int _deadlineSeconds;
+            CYahooSearchFilter _filter;
         };        
 
     private:
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <boost/algorithm/string/join.hpp>
 #include "yahoo_url_factory.h"
 
 namespace watchList
@@ -15,16 +16,38 @@ namespace watchList
         return "auctions.yahoo.co.jp";
     }
 
-    std::string CYahooUrlFactory::createTarget(const CYahooSearchQuery& searchQuery)
+    void CYahooUrlFactory::appendFilterParams(const CYahooSearchFilter& filter, std::string& target)
+    {
+        if (filter.getMinPriceJpy() != 0)
+        {
+            target += "min=" + std::to_string(filter.getMinPriceJpy()) + "&";
+        }
+        if (filter.getMaxPriceJpy() != 0)
+        {
+            target += "max=" + std::to_string(filter.getMaxPriceJpy()) + "&";
+        }
+        if (filter.isBuyNowOnly())
+        {
+            target += "fixed=1&";
+        }
+        if (filter.getCondition() != EYahooItemCondition::ANY)
+        {
+            target += "istatus=";
+            target += (filter.getCondition() == EYahooItemCondition::NEW) ? "1" : "2";
+            target += "&";
+        }
+    }
+
+    void CYahooUrlFactory::appendSearchParams(const CYahooSearchQuery& searchQuery, int firstAuction, int numAuctions, std::string& target)
     {
-        std::string keyword = createKeywordForUrl(searchQuery);
-        std::string target = "/search/search?p=";
-        target += keyword;
         target += "&auccat=";
         target += searchQuery.getCategory();
-        target += "&va=";
-        target += keyword;
-        target += "&is_postage_mode=1&dest_pref_code=13&exflg=1&b=1&n=100&s1=new&o1=d&";
+        target += "&is_postage_mode=1&dest_pref_code=13&exflg=1&b=";
+        target += std::to_string(firstAuction);
+        target += "&n=";
+        target += std::to_string(numAuctions);
+        target += "&s1=new&o1=d&";
+        appendFilterParams(searchQuery.getFilter(), target);
         
         if (searchQuery.getSearchMethod() == EYahooSearchMethod::FUZZY_SEARCH)
         {
@@ -42,6 +65,40 @@ namespace watchList
                 target += "4";
             }
         }
+    }
+
+    std::string CYahooUrlFactory::createTarget(const CYahooSearchQuery& searchQuery, int firstAuction, int numAuctions)
+    {
+        std::string keyword = createKeywordForUrl(searchQuery);
+        std::string target = "/search/search?p=";
+        target += keyword;
+        target += "&va=";
+        target += keyword;
+        appendSearchParams(searchQuery, firstAuction, numAuctions, target);
+        return target;
+    }
+
+    std::string CYahooUrlFactory::createTarget(const CYahooKeywordBatch& batch, int firstAuction, int numAuctions)
+    {
+        if (batch.isCategoryFeed())
+        {
+            // search without keyword lists all auctions of category
+            std::string target = "/search/search?p=";
+            appendSearchParams(batch.getSearchQuery(), firstAuction, numAuctions, target);
+            return target;
+        }
+        if (!batch.isBatch())
+        {
+            return createTarget(batch.getSearchQuery(), firstAuction, numAuctions);
+        }
+
+        // words in parentheses are searched with OR, the same words go to "any of words" field of detailed search
+        std::string orWords = boost::algorithm::join(batch.getOrWords(), "+");
+        std::string target = "/search/search?p=(";
+        target += orWords;
+        target += ")&vo=";
+        target += orWords;
+        appendSearchParams(batch.getSearchQuery(), firstAuction, numAuctions, target);
         return target;
     }
     
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "yahoo_search_query.h"
+#include "yahoo_keyword_batch.h"
 #include "url_factory.h"
 
 namespace watchList
@@ -9,14 +10,23 @@ namespace watchList
     {
     public:
         static std::string_view createHost();
-        static std::string createTarget(const CYahooSearchQuery& searchQuery);
+        // newest auctions come first, page starts with auction number firstAuction counting from 1
+        static std::string createTarget(const CYahooSearchQuery& searchQuery, int firstAuction = 1, int numAuctions = 100);
+        // batch of several keywords searches any of its OR words, category feed searches no keyword
+        static std::string createTarget(const CYahooKeywordBatch& batch, int firstAuction, int numAuctions);
         static std::string createTarget(std::string_view auctionId);
+
+    private:
+        // price range applies to current price, every param ends with '&'
+        static void appendFilterParams(const CYahooSearchFilter& filter, std::string& target);
+        static void appendSearchParams(const CYahooSearchQuery& searchQuery, int firstAuction, int numAuctions, std::string& target);
     };
     
     class CInjapanUrlFactory : public CSecureUrlFactory<CInjapanUrlFactory>
     {
     public:
         static std::string_view createHost();
+        // filter of query isn't passed to injapan search, report label shows it instead
         static std::string createTarget(const CYahooSearchQuery& searchQuery);
         static std::string createTarget(std::string_view auctionId);
     };    